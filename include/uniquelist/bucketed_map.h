@@ -0,0 +1,412 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Map of arrays with a separate tree for each size
+ */
+
+#ifndef UNIQUELIST_BUCKETED_MAP_H
+#define UNIQUELIST_BUCKETED_MAP_H
+
+#include <cstddef>
+#include <functional>  // std::less
+#include <iterator>    // std::bidirectional_iterator_tag
+#include <map>         // std::map
+#include <type_traits> // std::conditional_t, std::is_invocable_r
+#include <utility>     // std::pair
+#include <vector>      // std::vector
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Sizes below this are mapped to the trees by an array
+ */
+constexpr size_t bucket_index_limit = 1024;
+
+template <typename K> struct is_sized_ptr : std::false_type {};
+
+template <typename P> struct is_sized_ptr<sized_ptr<P>> : std::true_type {};
+
+/**
+ * @brief Comparison of elements used in a tree
+ *
+ * If `C` compares the elements, it is used as is.  If `C` is
+ * `std::less` of arrays, `std::less` of elements is used.  Otherwise,
+ * the keys are compared by `C`.
+ */
+template <typename C, typename E, typename = void> struct element_less {
+  static constexpr bool available = false;
+};
+
+template <typename C, typename E>
+struct element_less<
+    C, E, std::enable_if_t<std::is_invocable_r<bool, const C &, E, E>::value>> {
+  static constexpr bool available = true;
+  static const C &get(const C &comp) noexcept { return comp; }
+};
+
+template <typename K, typename E> struct element_less<std::less<K>, E, void> {
+  static constexpr bool available = true;
+  static std::less<E> get(const std::less<K> &) noexcept { return {}; }
+};
+
+} // namespace detail
+
+/**
+ * @brief Map of arrays with a separate tree for each size
+ *
+ * This is a map whose keys are arrays such as sized_ptr.  It keeps
+ * a std::map for each size of the arrays, so that a lookup only
+ * descends through the arrays of the same size.  The trees are kept
+ * in another std::map from the size, which usually has only a few
+ * entries, and small sizes are also mapped to the trees by an array.
+ * This may be used as the underlying map of uniquelist:
+ *
+ * ```
+ * uniquelist<sized_ptr<P>, strictly_less, bucketed_map> list;
+ * ```
+ *
+ * When the keys are sized_ptrs, the trees compare the elements
+ * directly, skipping the comparison of the sizes.
+ *
+ * `C` must order keys by their sizes first, as `strictly_less` and
+ * `operator<` of sized_ptr do.  Then the iteration visits the keys
+ * in the same order as a single std::map.
+ */
+template <typename K, typename V, typename C = std::less<K>>
+class bucketed_map {
+  using element_type = std::remove_const_t<
+      std::remove_extent_t<typename K::smart_pointer_type::element_type>>;
+
+  using element_less = detail::element_less<C, element_type>;
+
+  static constexpr bool compare_elements =
+      detail::is_sized_ptr<K>::value && element_less::available;
+
+public:
+  /**
+   * @brief Comparison of the keys of the same size
+   */
+  struct bucket_less {
+    using is_transparent = void;
+
+    C comp;
+
+    template <typename A, typename B>
+    bool operator()(const A &a, const B &b) const {
+      if constexpr (compare_elements) {
+        decltype(auto) less = element_less::get(comp);
+        auto p = a.ptr.get();
+        auto q = b.ptr.get();
+        for (size_t i = 0; i < a.size; ++i) {
+          if (less(p[i], q[i])) {
+            return true;
+          } else if (less(q[i], p[i])) {
+            return false;
+          }
+        }
+        return false;
+      } else {
+        return comp(a, b);
+      }
+    }
+  };
+
+private:
+  using bucket_type = std::map<K, V, bucket_less>;
+  using bucket_map = std::map<size_t, bucket_type>;
+
+  /**
+   * @brief Iterator visiting the trees in the increasing order of sizes
+   */
+  template <bool Const> class basic_iterator {
+    using map_pointer = std::conditional_t<Const, const bucket_map *,
+                                           bucket_map *>;
+    using outer_iterator =
+        std::conditional_t<Const, typename bucket_map::const_iterator,
+                           typename bucket_map::iterator>;
+    using inner_iterator =
+        std::conditional_t<Const, typename bucket_type::const_iterator,
+                           typename bucket_type::iterator>;
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<const K, V>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+    using reference =
+        std::conditional_t<Const, const value_type &, value_type &>;
+
+    basic_iterator() = default;
+
+    basic_iterator(map_pointer buckets, outer_iterator outer,
+                   inner_iterator inner = {})
+        : buckets{buckets}, outer{outer}, inner{inner} {}
+
+    operator basic_iterator<true>() const {
+      return {buckets, outer, inner};
+    }
+
+    reference operator*() const { return *inner; }
+
+    pointer operator->() const { return &*inner; }
+
+    basic_iterator &operator++() {
+      if (++inner == outer->second.end()) {
+        if (++outer != buckets->end()) {
+          inner = outer->second.begin();
+        }
+      }
+      return *this;
+    }
+
+    basic_iterator &operator--() {
+      if (outer == buckets->end() || inner == outer->second.begin()) {
+        --outer;
+        inner = outer->second.end();
+      }
+      --inner;
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      auto buf = *this;
+      ++*this;
+      return buf;
+    }
+
+    basic_iterator operator--(int) {
+      auto buf = *this;
+      --*this;
+      return buf;
+    }
+
+    template <bool B> bool operator==(const basic_iterator<B> &other) const {
+      return outer == other.outer &&
+             (outer == buckets->end() || inner == other.inner);
+    }
+
+    template <bool B> bool operator!=(const basic_iterator<B> &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    template <bool> friend class basic_iterator;
+    friend class bucketed_map;
+
+    map_pointer buckets = nullptr;
+    outer_iterator outer{};
+    inner_iterator inner{};
+  };
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using key_compare = C;
+  using size_type = size_t;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  explicit bucketed_map(const C &comp = C{}) : comp{comp} {}
+
+  bucketed_map(const bucketed_map &) = delete;
+
+  bucketed_map &operator=(const bucketed_map &) = delete;
+
+  /* Iterators */
+
+  iterator begin() noexcept { return first(buckets.begin()); }
+
+  const_iterator begin() const noexcept {
+    auto outer = buckets.begin();
+    if (outer == buckets.end()) {
+      return {&buckets, outer};
+    }
+    return {&buckets, outer, outer->second.begin()};
+  }
+
+  iterator end() noexcept { return {&buckets, buckets.end()}; }
+
+  const_iterator end() const noexcept { return {&buckets, buckets.end()}; }
+
+  /* Capacity */
+
+  bool empty() const noexcept { return count_ == 0; }
+
+  size_t size() const noexcept { return count_; }
+
+  size_t max_size() const noexcept { return buckets.max_size(); }
+
+  /** Return the number of trees, that is, distinct sizes. */
+  size_t bucket_count() const noexcept { return buckets.size(); }
+
+  /* Observers */
+
+  C key_comp() const { return comp; }
+
+  /* Lookup */
+
+  template <typename Q> iterator find(const Q &key) {
+    auto outer = locate(key.size);
+    if (outer == buckets.end()) {
+      return end();
+    }
+    auto inner = outer->second.find(key);
+    if (inner == outer->second.end()) {
+      return end();
+    }
+    return {&buckets, outer, inner};
+  }
+
+  template <typename Q> const_iterator find(const Q &key) const {
+    return const_cast<bucketed_map *>(this)->find(key);
+  }
+
+  template <typename Q> size_t count(const Q &key) const {
+    auto outer = const_cast<bucketed_map *>(this)->locate(key.size);
+    return outer != buckets.end() && outer->second.count(key) > 0;
+  }
+
+  template <typename Q> iterator lower_bound(const Q &key) {
+    auto outer = buckets.lower_bound(key.size);
+    if (outer != buckets.end() && outer->first == key.size) {
+      auto inner = outer->second.lower_bound(key);
+      if (inner != outer->second.end()) {
+        return {&buckets, outer, inner};
+      }
+      ++outer;
+    }
+    return first(outer);
+  }
+
+  template <typename Q> iterator upper_bound(const Q &key) {
+    auto outer = buckets.lower_bound(key.size);
+    if (outer != buckets.end() && outer->first == key.size) {
+      auto inner = outer->second.upper_bound(key);
+      if (inner != outer->second.end()) {
+        return {&buckets, outer, inner};
+      }
+      ++outer;
+    }
+    return first(outer);
+  }
+
+  /* Modifiers */
+
+  template <typename P> std::pair<iterator, bool> insert(P &&value) {
+    return try_emplace(std::forward<P>(value).first,
+                       std::forward<P>(value).second);
+  }
+
+  template <typename Q, typename... Args>
+  std::pair<iterator, bool> try_emplace(Q &&key, Args &&...args) {
+    auto outer = bucket(key.size);
+    auto [inner, status] = outer->second.try_emplace(
+        std::forward<Q>(key), std::forward<Args>(args)...);
+    count_ += status;
+    return {iterator{&buckets, outer, inner}, status};
+  }
+
+  /**
+   * @brief Insert an element
+   *
+   * The hint is used if it points to the tree of the same size.
+   */
+  template <typename Q, typename... Args>
+  iterator emplace_hint(const_iterator hint, Q &&key, Args &&...args) {
+    auto outer = bucket(key.size);
+    auto &tree = outer->second;
+    auto size = tree.size();
+    auto inner =
+        (hint.outer != buckets.end() && hint.outer->first == outer->first)
+            ? tree.emplace_hint(hint.inner, std::forward<Q>(key),
+                                std::forward<Args>(args)...)
+            : tree.emplace_hint(tree.end(), std::forward<Q>(key),
+                                std::forward<Args>(args)...);
+    count_ += tree.size() - size;
+    return {&buckets, outer, inner};
+  }
+
+  iterator erase(iterator position) {
+    auto outer = position.outer;
+    auto inner = outer->second.erase(position.inner);
+    --count_;
+    if (outer->second.empty()) {
+      if (outer->first < index.size()) {
+        index[outer->first] = buckets.end();
+      }
+      return first(buckets.erase(outer));
+    } else if (inner == outer->second.end()) {
+      return first(++outer);
+    }
+    return {&buckets, outer, inner};
+  }
+
+  void clear() noexcept {
+    buckets.clear();
+    index.clear();
+    count_ = 0;
+  }
+
+private:
+  /**
+   * @brief Return the first element in a given tree or later
+   */
+  iterator first(typename bucket_map::iterator outer) noexcept {
+    if (outer == buckets.end()) {
+      return {&buckets, outer};
+    }
+    return {&buckets, outer, outer->second.begin()};
+  }
+
+  /**
+   * @brief Return the tree of a given size or `buckets.end()`
+   */
+  typename bucket_map::iterator locate(size_t size) {
+    if (size < index.size()) {
+      return index[size];
+    } else if (size < detail::bucket_index_limit) {
+      return buckets.end();
+    }
+    return buckets.find(size);
+  }
+
+  /**
+   * @brief Return the tree of a given size, creating it if necessary
+   */
+  typename bucket_map::iterator bucket(size_t size) {
+    auto outer = locate(size);
+    if (outer != buckets.end()) {
+      return outer;
+    }
+    outer = buckets.emplace(size, bucket_type{bucket_less{comp}}).first;
+    if (size < detail::bucket_index_limit) {
+      if (index.size() <= size) {
+        index.resize(size + 1, buckets.end());
+      }
+      index[size] = outer;
+    }
+    return outer;
+  }
+
+  C comp;
+
+  /** Map from a size to the tree of the arrays of the size. */
+  bucket_map buckets{};
+
+  /** Trees of small sizes indexed by the size. */
+  std::vector<typename bucket_map::iterator> index{};
+
+  /** Number of elements. */
+  size_t count_ = 0;
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_BUCKETED_MAP_H
@@ -0,0 +1,448 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Array which is compressed when it is not used for a while
+ */
+
+#ifndef UNIQUELIST_COMPRESSED_PTR_H
+#define UNIQUELIST_COMPRESSED_PTR_H
+
+#include <algorithm> // std::copy
+#include <cstddef>
+#include <cstdint>    // std::uint64_t etc
+#include <cstring>    // std::memcpy
+#include <functional> // std::less
+#include <memory>     // std::shared_ptr, std::unique_ptr
+#include <stdexcept>  // std::invalid_argument
+#include <vector>     // std::vector
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+template <size_t N> struct unsigned_of_size;
+template <> struct unsigned_of_size<1> { using type = std::uint8_t; };
+template <> struct unsigned_of_size<2> { using type = std::uint16_t; };
+template <> struct unsigned_of_size<4> { using type = std::uint32_t; };
+template <> struct unsigned_of_size<8> { using type = std::uint64_t; };
+
+template <typename T> using bits_t = typename unsigned_of_size<sizeof(T)>::type;
+
+template <typename T> bits_t<T> to_bits(T x) noexcept {
+  bits_t<T> u;
+  std::memcpy(&u, &x, sizeof(T));
+  return u;
+}
+
+template <typename T> T from_bits(bits_t<T> u) noexcept {
+  T x;
+  std::memcpy(&x, &u, sizeof(T));
+  return x;
+}
+
+/**
+ * @brief Encode an array by XORing the bits of consecutive elements
+ *
+ * Each element is XORed with the previous one.  The result is written
+ * as a header byte, whose upper and lower 4 bits are the numbers of
+ * the leading and trailing zero bytes, followed by the remaining bytes.
+ * A repeated value takes 1 byte and small integers or values sharing
+ * the exponent with the previous one take a few bytes.
+ */
+template <typename T>
+std::vector<unsigned char> xor_encode(const T *p, size_t n) {
+  using U = bits_t<T>;
+  constexpr size_t width = sizeof(U);
+  std::vector<unsigned char> out;
+  out.reserve(n * 2);
+  U prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto bits = to_bits(p[i]);
+    U x = bits ^ prev;
+    prev = bits;
+    size_t lead = 0;
+    while (lead < width && ((x >> (8 * (width - 1 - lead))) & 0xff) == 0) {
+      ++lead;
+    }
+    size_t trail = 0;
+    if (lead < width) {
+      while (((x >> (8 * trail)) & 0xff) == 0) {
+        ++trail;
+      }
+    }
+    out.push_back(static_cast<unsigned char>((lead << 4) | trail));
+    for (size_t b = trail; b < width - lead; ++b) {
+      out.push_back(static_cast<unsigned char>((x >> (8 * b)) & 0xff));
+    }
+  }
+  out.shrink_to_fit();
+  return out;
+}
+
+/**
+ * @brief Decode elements encoded by xor_encode one by one
+ */
+template <typename T> struct xor_decoder {
+  const unsigned char *pos = nullptr;
+  bits_t<T> prev = 0;
+
+  T next() noexcept {
+    using U = bits_t<T>;
+    constexpr size_t width = sizeof(U);
+    size_t lead = *pos >> 4;
+    size_t trail = *pos & 0x0f;
+    ++pos;
+    U x = 0;
+    for (size_t b = trail; b < width - lead; ++b) {
+      x |= static_cast<U>(static_cast<U>(*pos++) << (8 * b));
+    }
+    prev ^= x;
+    return from_bits<T>(prev);
+  }
+};
+
+template <typename T> struct cold_state;
+
+/**
+ * @brief Memory block of compressed_ptr
+ *
+ * The elements are either kept in `data` or encoded in `encoded`.
+ * `data` points to `owned` unless the block is a view of an external
+ * array.
+ */
+template <typename T> struct cold_block {
+  std::shared_ptr<cold_state<T>> state;
+  size_t size = 0;
+  size_t last_used = 0;
+  const T *data = nullptr;
+  std::unique_ptr<T[]> owned;
+  std::vector<unsigned char> encoded;
+  bool is_compressed = false;
+
+  ~cold_block();
+
+  bool compressed() const noexcept { return is_compressed; }
+
+  /** Release the array and keep the encoded elements instead. */
+  bool compress();
+};
+
+/**
+ * @brief State shared by a cold_storage and its blocks
+ */
+template <typename T> struct cold_state {
+  size_t clock = 0;
+  size_t compress_after = 0;
+  size_t visits_per_tick = 0;
+  /** Blocks which may be compressed. */
+  std::vector<std::weak_ptr<cold_block<T>>> blocks{};
+  /** Position in `blocks` visited next. */
+  size_t cursor = 0;
+  size_t dense_bytes = 0;
+  size_t compressed_bytes = 0;
+  size_t compressed_blocks = 0;
+};
+
+template <typename T> cold_block<T>::~cold_block() {
+  if (!state) {
+    return;
+  }
+  if (compressed()) {
+    state->compressed_bytes -= encoded.capacity();
+    --state->compressed_blocks;
+  } else if (owned) {
+    state->dense_bytes -= size * sizeof(T);
+  }
+}
+
+template <typename T> bool cold_block<T>::compress() {
+  if (compressed() || !owned) {
+    return false;
+  }
+  auto buf = xor_encode(data, size);
+  if (buf.capacity() >= size * sizeof(T)) {
+    return false; // Not worth compressing.
+  }
+  encoded = std::move(buf);
+  owned.reset();
+  data = nullptr;
+  is_compressed = true;
+  state->dense_bytes -= size * sizeof(T);
+  state->compressed_bytes += encoded.capacity();
+  ++state->compressed_blocks;
+  return true;
+}
+
+/**
+ * @brief Read the elements of a block one by one
+ */
+template <typename T> struct cold_reader {
+  const T *data;
+  xor_decoder<T> decoder;
+
+  explicit cold_reader(const cold_block<T> &block) noexcept
+      : data{block.data}, decoder{block.encoded.data()} {}
+
+  T next() noexcept { return data ? *data++ : decoder.next(); }
+};
+
+} // namespace detail
+
+/**
+ * @brief Array which is compressed when it is not used for a while
+ *
+ * This is a key type of uniquelist which keeps an array of
+ * floating point numbers like sized_ptr.  It is created by
+ * `cold_storage`, which compresses the arrays not used for a given
+ * number of operations.  The compression is lossless, and compressed
+ * arrays are decoded element by element during the comparison, so
+ * that they are never expanded in memory.
+ *
+ * Two compressed_ptrs are compared in the shortlex order using `<`
+ * operator.  `strictly_less` compares them with a tolerance.
+ */
+template <typename T> struct compressed_ptr {
+  using element_type = T;
+
+  size_t size;
+  std::shared_ptr<detail::cold_block<T>> block;
+
+  /** Test if the elements are compressed. */
+  bool compressed() const noexcept { return block->compressed(); }
+
+  /** Mark the array as used at the current clock. */
+  void touch() const noexcept { block->last_used = block->state->clock; }
+
+  /** Copy the elements to a given buffer of size `size`. */
+  void copy_to(T *out) const {
+    touch();
+    detail::cold_reader<T> reader{*block};
+    for (size_t i = 0; i < size; ++i) {
+      out[i] = reader.next();
+    }
+  }
+
+  /** Return the elements as a vector. */
+  std::vector<T> decode() const {
+    std::vector<T> out(size);
+    copy_to(out.data());
+    return out;
+  }
+
+  template <typename U>
+  friend bool operator<(const compressed_ptr<T> &l,
+                        const compressed_ptr<U> &r) {
+    return compressed_less(std::less<T>{}, l, r);
+  }
+};
+
+/**
+ * @brief Compare two compressed_ptrs in the shortlex order
+ *
+ * The elements are compared one by one using `less`.  Compressed
+ * elements are decoded on the fly, and only up to the first
+ * element which differs.
+ */
+template <typename L, typename T, typename U>
+bool compressed_less(const L &less, const compressed_ptr<T> &a,
+                     const compressed_ptr<U> &b) {
+  if (a.size != b.size) {
+    return a.size < b.size;
+  }
+  a.touch();
+  b.touch();
+  if (!a.compressed() && !b.compressed()) {
+    auto p = a.block->data;
+    auto q = b.block->data;
+    for (size_t i = 0; i < a.size; ++i) {
+      if (less(p[i], q[i])) {
+        return true;
+      } else if (less(q[i], p[i])) {
+        return false;
+      }
+    }
+    return false;
+  }
+  detail::cold_reader<T> p{*a.block};
+  detail::cold_reader<U> q{*b.block};
+  for (size_t i = 0; i < a.size; ++i) {
+    auto x = p.next();
+    auto y = q.next();
+    if (less(x, y)) {
+      return true;
+    } else if (less(y, x)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Compare two compressed_ptrs with a tolerance
+ *
+ * This is called by `strictly_less`.
+ */
+template <typename T, typename U>
+bool tolerant_less(const strictly_less &less, const compressed_ptr<T> &a,
+                   const compressed_ptr<U> &b) {
+  return compressed_less(less, a, b);
+}
+
+/**
+ * @brief Storage which compresses arrays not used for a while
+ *
+ * This creates compressed_ptrs and keeps a clock counting operations.
+ * `tick` advances the clock and visits a few arrays created by `copy`.
+ * An array which is not compared or read for `compress_after` ticks
+ * is compressed when visited.  Since only a constant number of arrays
+ * are visited per tick, the compression costs amortised constant time
+ * and it does not need a separate thread.
+ *
+ * An instance is a handle to a shared state, so that copies refer to
+ * the same storage.  Neither the storage nor the arrays may be used
+ * by more than one thread at the same time.
+ *
+ * ```
+ * uniquelist::cold_storage<double> storage{1000};
+ * uniquelist::uniquelist<uniquelist::compressed_ptr<double>,
+ *                        uniquelist::strictly_less> list;
+ * list.push_back_with_hook(storage.view(p, n), [&](const auto &x) {
+ *   return storage.copy(x);
+ * });
+ * storage.tick();
+ * ```
+ */
+template <typename T> class cold_storage {
+public:
+  /**
+   * @brief Create a storage
+   *
+   * @param [in] compress_after Number of ticks after which
+   *     an unused array is compressed.
+   * @param [in] visits_per_tick Number of arrays visited per tick.
+   */
+  explicit cold_storage(size_t compress_after = 1024,
+                        size_t visits_per_tick = 2)
+      : state{std::make_shared<detail::cold_state<T>>()} {
+    if (visits_per_tick == 0) {
+      throw std::invalid_argument("visits_per_tick must be positive");
+    }
+    state->compress_after = compress_after;
+    state->visits_per_tick = visits_per_tick;
+  }
+
+  /**
+   * @brief Create a view of an external array
+   *
+   * The returned compressed_ptr does not own the array and is never
+   * compressed.  This may be used to search for an array without
+   * copying it.
+   */
+  compressed_ptr<T> view(const T *p, size_t size) const {
+    auto block = std::make_shared<detail::cold_block<T>>();
+    block->state = state;
+    block->size = size;
+    block->last_used = state->clock;
+    block->data = p;
+    return {size, std::move(block)};
+  }
+
+  /**
+   * @brief Copy an array into the storage
+   */
+  compressed_ptr<T> copy(const T *p, size_t size) {
+    std::unique_ptr<T[]> owned{new T[size]};
+    std::copy(p, p + size, owned.get());
+    auto block = std::make_shared<detail::cold_block<T>>();
+    block->state = state;
+    block->size = size;
+    block->last_used = state->clock;
+    block->data = owned.get();
+    block->owned = std::move(owned);
+    state->dense_bytes += size * sizeof(T);
+    state->blocks.push_back(block);
+    return {size, std::move(block)};
+  }
+
+  /**
+   * @brief Copy a compressed_ptr into the storage
+   */
+  compressed_ptr<T> copy(const compressed_ptr<T> &p) {
+    if (p.compressed()) {
+      return copy(p.decode().data(), p.size);
+    }
+    return copy(p.block->data, p.size);
+  }
+
+  /**
+   * @brief Advance the clock by one operation
+   *
+   * This visits up to `visits_per_tick` arrays and compresses the ones
+   * not used for `compress_after` ticks.
+   */
+  void tick() {
+    auto &blocks = state->blocks;
+    ++state->clock;
+    for (size_t i = 0; i < state->visits_per_tick && !blocks.empty(); ++i) {
+      if (state->cursor >= blocks.size()) {
+        state->cursor = 0;
+      }
+      auto block = blocks[state->cursor].lock();
+      if (!block || block->compressed()) {
+        // Forget arrays which are removed or already compressed.
+        blocks[state->cursor] = std::move(blocks.back());
+        blocks.pop_back();
+        continue;
+      }
+      if (state->clock - block->last_used >= state->compress_after) {
+        block->compress();
+      }
+      ++state->cursor;
+    }
+  }
+
+  /**
+   * @brief Compress all arrays not used for `compress_after` ticks
+   */
+  void compress_unused() {
+    auto &blocks = state->blocks;
+    for (size_t i = 0; i < blocks.size();) {
+      auto block = blocks[i].lock();
+      if (block && !block->compressed() &&
+          state->clock - block->last_used >= state->compress_after) {
+        block->compress();
+      }
+      if (!block || block->compressed()) {
+        blocks[i] = std::move(blocks.back());
+        blocks.pop_back();
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  /** Return the current clock. */
+  size_t clock() const noexcept { return state->clock; }
+
+  /** Return the number of bytes used by the uncompressed arrays. */
+  size_t dense_bytes() const noexcept { return state->dense_bytes; }
+
+  /** Return the number of bytes used by the compressed arrays. */
+  size_t compressed_bytes() const noexcept { return state->compressed_bytes; }
+
+  /** Return the number of compressed arrays. */
+  size_t compressed_count() const noexcept {
+    return state->compressed_blocks;
+  }
+
+private:
+  std::shared_ptr<detail::cold_state<T>> state;
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_COMPRESSED_PTR_H
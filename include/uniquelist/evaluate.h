@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Products of the arrays in a list with a vector
+ */
+
+#ifndef UNIQUELIST_EVALUATE_H
+#define UNIQUELIST_EVALUATE_H
+
+#include <algorithm> // std::partial_sort
+#include <cstddef>
+#include <stdexcept> // std::invalid_argument
+#include <utility>   // std::pair
+#include <vector>
+
+#include "uniquelist/parallel.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Number of multiply-adds below which a chunk is not split
+ */
+constexpr size_t evaluate_grain = size_t{1} << 16;
+
+/**
+ * @brief Compute the dot products of rows with a vector
+ *
+ * Four rows are processed at a time with four partial sums each, so
+ * that each element of `x` is loaded once for the four rows and the
+ * partial sums can be kept in vector registers.
+ */
+template <typename T>
+void dot_rows(const T *const *rows, size_t n, size_t d, const double *x,
+              double *out) noexcept {
+  constexpr size_t R = 4;
+  constexpr size_t L = 4;
+  size_t i = 0;
+  for (; i + R <= n; i += R) {
+    double acc[R][L] = {};
+    size_t j = 0;
+    for (; j + L <= d; j += L) {
+      for (size_t r = 0; r < R; ++r) {
+        for (size_t l = 0; l < L; ++l) {
+          acc[r][l] += rows[i + r][j + l] * x[j + l];
+        }
+      }
+    }
+    for (size_t r = 0; r < R; ++r) {
+      double sum = (acc[r][0] + acc[r][1]) + (acc[r][2] + acc[r][3]);
+      for (size_t k = j; k < d; ++k) {
+        sum += rows[i + r][k] * x[k];
+      }
+      out[i + r] = sum;
+    }
+  }
+  for (; i < n; ++i) {
+    double sum = 0;
+    for (size_t k = 0; k < d; ++k) {
+      sum += rows[i][k] * x[k];
+    }
+    out[i] = sum;
+  }
+}
+
+/**
+ * @brief Collect the pointers to the arrays in the order of addition
+ *
+ * @throw std::invalid_argument if an array is not of size d.
+ */
+template <typename List>
+auto collect_rows(const List &list, size_t d) {
+  std::vector<const double *> rows;
+  rows.reserve(list.size());
+  for (const auto &item : list) {
+    if (item.size != d) {
+      throw std::invalid_argument(
+          "all arrays must have the same size as x");
+    }
+    rows.push_back(item.ptr.get());
+  }
+  return rows;
+}
+
+} // namespace detail
+
+/**
+ * @brief Compute the dot products of the arrays in a list with a vector
+ *
+ * This computes `a_i x` for each array `a_i` in the order of addition.
+ * The rows are split into blocks computed by `threads` threads.
+ *
+ * @param [in] list List of sized_ptrs of doubles.
+ * @param [in] x Vector.  size: d
+ * @param [in] d Size of `x`, which must be the size of all arrays.
+ * @param [out] out Dot products.  size: list.size()
+ * @param [in] threads Number of threads.  0 means the number of
+ *     hardware threads.
+ *
+ * @throw std::invalid_argument if an array is not of size d.
+ */
+template <typename List>
+void evaluate(const List &list, const double *x, size_t d, double *out,
+              unsigned threads = 0) {
+  auto rows = detail::collect_rows(list, d);
+  auto grain = detail::evaluate_grain / std::max<size_t>(d, 1) + 1;
+  parallel_for(
+      rows.size(), grain,
+      [&](size_t begin, size_t end) {
+        detail::dot_rows(rows.data() + begin, end - begin, d, x,
+                         out + begin);
+      },
+      threads);
+}
+
+/**
+ * @brief Find the arrays most violated at a point
+ *
+ * This regards the arrays in a list as constraints `a_i x <= rhs_i`
+ * and returns the k largest violations `a_i x - rhs_i` which are
+ * larger than `tol`.
+ *
+ * @param [in] rhs Right-hand sides.  size: list.size()
+ * @param [in] k Maximum number of arrays returned.
+ * @param [in] tol Violations smaller than or equal to this are ignored.
+ *
+ * @return Pairs of the positions of the arrays and the violations,
+ *     sorted in the decreasing order of the violations.
+ */
+template <typename List>
+std::vector<std::pair<size_t, double>>
+most_violated(const List &list, const double *x, size_t d, const double *rhs,
+              size_t k, double tol = 0.0, unsigned threads = 0) {
+  std::vector<double> value(list.size());
+  evaluate(list, x, d, value.data(), threads);
+  std::vector<std::pair<size_t, double>> out;
+  for (size_t i = 0; i < value.size(); ++i) {
+    auto violation = value[i] - rhs[i];
+    if (violation > tol) {
+      out.emplace_back(i, violation);
+    }
+  }
+  auto larger = [](const auto &a, const auto &b) {
+    return (a.second > b.second) ||
+           (a.second == b.second && a.first < b.first);
+  };
+  if (out.size() > k) {
+    std::partial_sort(out.begin(), out.begin() + static_cast<long>(k),
+                      out.end(), larger);
+    out.resize(k);
+  } else {
+    std::sort(out.begin(), out.end(), larger);
+  }
+  return out;
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_EVALUATE_H
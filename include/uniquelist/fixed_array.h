@@ -0,0 +1,151 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Array whose size is known at compile time
+ */
+
+#ifndef UNIQUELIST_FIXED_ARRAY_H
+#define UNIQUELIST_FIXED_ARRAY_H
+
+#include <algorithm>  // std::copy
+#include <cstddef>
+#include <functional> // std::less
+#include <type_traits> // std::remove_const_t
+#include <utility>    // std::index_sequence
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Maximum size of arrays whose comparison is unrolled
+ *
+ * Arrays longer than this are compared in an ordinary loop
+ * to keep the generated code small.
+ */
+constexpr size_t fixed_array_unroll_limit = 32;
+
+/**
+ * @brief Compare two arrays lexicographically with unrolled code
+ *
+ * The fold expression stops at the first index `i` where either
+ * `less(p[i], q[i])` or `less(q[i], p[i])` holds.
+ */
+template <typename T, typename L, size_t... I>
+constexpr bool unrolled_less(const T *p, const T *q, const L &less,
+                             std::index_sequence<I...>) {
+  bool result = false;
+  (void)((less(p[I], q[I]) ? (result = true) : less(q[I], p[I])) || ...);
+  return result;
+}
+
+/**
+ * @brief Compare two arrays of size N lexicographically
+ */
+template <size_t N, typename T, typename L>
+constexpr bool fixed_less(const T *p, const T *q, const L &less) {
+  if constexpr (N <= fixed_array_unroll_limit) {
+    return unrolled_less(p, q, less, std::make_index_sequence<N>{});
+  } else {
+    for (size_t i = 0; i < N; ++i) {
+      if (less(p[i], q[i])) {
+        return true;
+      } else if (less(q[i], p[i])) {
+        return false;
+      }
+    }
+    return false;
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Array whose size is fixed at compile time
+ *
+ * This keeps N values inline, so that no pointer has to be
+ * dereferenced to compare two instances.  This may be used as a key
+ * of uniquelist instead of sized_ptr when all arrays have the same
+ * known size.
+ *
+ * ```
+ * uniquelist::uniquelist<fixed_array<double, 3>, strictly_less> list;
+ * list.push_back({{1.0, 2.0, 3.0}});
+ * ```
+ *
+ * Since all instances have the same size, the comparison does not
+ * check the size and, for small N, is unrolled at compile time.
+ */
+template <typename T, size_t N> struct fixed_array {
+  static_assert(N > 0, "fixed_array must have at least one element");
+
+  using value_type = T;
+
+  static constexpr size_t size = N;
+
+  T data[N];
+
+  constexpr T &operator[](size_t i) noexcept { return data[i]; }
+
+  constexpr const T &operator[](size_t i) const noexcept { return data[i]; }
+
+  constexpr T *begin() noexcept { return data; }
+
+  constexpr const T *begin() const noexcept { return data; }
+
+  constexpr T *end() noexcept { return data + N; }
+
+  constexpr const T *end() const noexcept { return data + N; }
+
+  /**
+   * @brief Compare two fixed_array instances lexicographically
+   */
+  friend constexpr bool operator<(const fixed_array &l, const fixed_array &r) {
+    return detail::fixed_less<N>(l.data, r.data, std::less<T>{});
+  }
+
+  /**
+   * @brief Test if two fixed_array instances have the same elements
+   */
+  friend constexpr bool operator==(const fixed_array &l,
+                                   const fixed_array &r) {
+    return !(l < r) && !(r < l);
+  }
+
+  friend constexpr bool operator!=(const fixed_array &l,
+                                   const fixed_array &r) {
+    return !(l == r);
+  }
+};
+
+/**
+ * @brief Compare two fixed_array instances with a tolerance
+ *
+ * This is called by `strictly_less` and compares the elements
+ * lexicographically using the tolerance of `less`.
+ */
+template <typename T, size_t N>
+constexpr bool tolerant_less(const strictly_less &less,
+                             const fixed_array<T, N> &a,
+                             const fixed_array<T, N> &b) {
+  return detail::fixed_less<N>(a.data, b.data, less);
+}
+
+/**
+ * @brief Copy an array to a fixed_array
+ *
+ * This copies the first N elements pointed by `p`.
+ */
+template <size_t N, typename T> auto as_fixed_array(const T *p) {
+  fixed_array<std::remove_const_t<T>, N> out{};
+  std::copy(p, p + N, out.data);
+  return out;
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_FIXED_ARRAY_H
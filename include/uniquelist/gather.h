@@ -0,0 +1,116 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Copy of the arrays in a list to consecutive memory
+ */
+
+#ifndef UNIQUELIST_GATHER_H
+#define UNIQUELIST_GATHER_H
+
+#include <algorithm> // std::copy, std::max
+#include <cstddef>
+#include <vector>
+
+#include "uniquelist/parallel.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Number of elements below which a chunk is not split
+ */
+constexpr size_t gather_grain = size_t{1} << 16;
+
+} // namespace detail
+
+/**
+ * @brief Pointers to arrays and their offsets in consecutive memory
+ *
+ * The i-th array is `rows[i]` of size `offsets[i + 1] - offsets[i]`,
+ * which is placed at `offsets[i]` when the arrays are concatenated.
+ */
+template <typename T> struct array_layout {
+  std::vector<const T *> rows{};
+  std::vector<size_t> offsets{0};
+
+  /** Return the number of arrays. */
+  size_t size() const noexcept { return rows.size(); }
+
+  /** Return the size of the i-th array. */
+  size_t size(size_t i) const noexcept {
+    return offsets[i + 1] - offsets[i];
+  }
+};
+
+/**
+ * @brief Collect the arrays in a range of sized_ptrs
+ *
+ * ```
+ * auto inserted = layout_of<double>(std::begin(list), std::end(list));
+ * auto sorted = layout_of<double>(list.sbegin(), list.send());
+ * ```
+ */
+template <typename T, typename It>
+array_layout<T> layout_of(It first, It last) {
+  array_layout<T> out;
+  for (; first != last; ++first) {
+    out.rows.push_back(first->ptr.get());
+    out.offsets.push_back(out.offsets.back() + first->size);
+  }
+  return out;
+}
+
+/**
+ * @brief Collect the arrays at given positions in a list
+ *
+ * @param [in] n Number of positions.
+ * @param [in] positions Positions of the arrays.  size: n
+ *
+ * @throw std::out_of_range if a position is not smaller than the size
+ *     of the list.
+ */
+template <typename T, typename List, typename U>
+array_layout<T> layout_at(List &list, size_t n, const U *positions) {
+  array_layout<T> out;
+  out.rows.reserve(n);
+  out.offsets.reserve(n + 1);
+  for (size_t i = 0; i < n; ++i) {
+    const auto &item = list.at(static_cast<size_t>(positions[i]));
+    out.rows.push_back(item.ptr.get());
+    out.offsets.push_back(out.offsets.back() + item.size);
+  }
+  return out;
+}
+
+/**
+ * @brief Copy arrays to consecutive memory
+ *
+ * The arrays are split into blocks copied by `threads` threads.
+ *
+ * @param [in] layout Arrays and their offsets.
+ * @param [out] out Concatenated arrays.  size: layout.offsets.back()
+ * @param [in] threads Number of threads.  0 means the number of
+ *     hardware threads.
+ */
+template <typename T>
+void gather(const array_layout<T> &layout, T *out, unsigned threads = 0) {
+  auto n = layout.size();
+  auto average = layout.offsets.back() / std::max<size_t>(n, 1);
+  auto grain = detail::gather_grain / std::max<size_t>(average, 1) + 1;
+  parallel_for(
+      n, grain,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          std::copy(layout.rows[i], layout.rows[i] + layout.size(i),
+                    out + layout.offsets[i]);
+        }
+      },
+      threads);
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_GATHER_H
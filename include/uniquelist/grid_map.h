@@ -0,0 +1,374 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Hash map of arrays equal within a tolerance
+ */
+
+#ifndef UNIQUELIST_GRID_MAP_H
+#define UNIQUELIST_GRID_MAP_H
+
+#include <algorithm> // std::min
+#include <cmath>     // std::floor, std::log1p
+#include <cstddef>
+#include <cstdint>       // std::int64_t, std::uint64_t
+#include <iterator>      // std::prev
+#include <list>          // std::list
+#include <stdexcept>     // std::invalid_argument
+#include <tuple>         // std::forward_as_tuple
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::pair
+#include <vector>        // std::vector
+
+#include "uniquelist/fixed_array.h"
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+template <typename P> auto elements(const sized_ptr<P> &key) noexcept {
+  return key.ptr.get();
+}
+
+template <typename T, size_t N>
+auto elements(const fixed_array<T, N> &key) noexcept {
+  return key.data;
+}
+
+} // namespace detail
+
+/**
+ * @brief Parameters of the grid used by grid_map
+ *
+ * `cell_width` is the width of a cell relative to the tolerance and
+ * `hashed_size` is the maximum number of leading elements used to
+ * compute the hash.  Wider cells make neighbouring cells probed less
+ * often while more arrays share a cell.
+ */
+struct grid_options {
+  double cell_width = 32.0;
+  size_t hashed_size = 8;
+};
+
+/**
+ * @brief Hash map of arrays equal within a tolerance
+ *
+ * This is a map whose keys are arrays (sized_ptr or fixed_array) and
+ * two keys are considered equal if neither is `strictly_less` than
+ * the other.  This may be used as the underlying map of uniquelist:
+ *
+ * ```
+ * uniquelist<sized_ptr<P>, strictly_less, grid_map> list;
+ * ```
+ *
+ * Each element is mapped by
+ *
+ * ```
+ * u(x) = sign(x) log(1 + rtol |x| / atol) / rtol
+ * ```
+ *
+ * so that two elements equal within the tolerance are at most
+ * `1 / (1 - rtol)` apart after the mapping.  The mapped elements are
+ * snapped to a grid of width `cell_width` and the indexes of the
+ * cells are hashed together with the size of the array.  A key is
+ * stored only in its own cell.  On lookup the cell of the query is
+ * searched, and a neighbouring cell is searched only if an element
+ * of the query lies within the tolerance of the cell boundary.
+ * Candidates found in the cells are confirmed by `strictly_less`.
+ *
+ * Since `strictly_less` is not transitive, a query may be equal to
+ * more than one stored key.  In that case the key stored first is
+ * returned, so that the result does not depend on the layout of the
+ * hash table.
+ *
+ * Iterating over this map visits the elements in the order they are
+ * inserted, not in the increasing order.  `atol` must be positive
+ * unless both of `rtol` and `atol` are zero.
+ */
+template <typename K, typename V, typename C = strictly_less> class grid_map {
+
+  /**
+   * @brief Node keeping a key-value pair and its hash
+   */
+  struct node : std::pair<const K, V> {
+    template <typename... Args>
+    node(size_t hash, size_t order, Args &&...args)
+        : std::pair<const K, V>(std::forward<Args>(args)...), hash{hash},
+          order{order} {}
+
+    size_t hash;
+    size_t order;
+  };
+
+  using node_list = std::list<node>;
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using key_compare = C;
+  using size_type = size_t;
+  using iterator = typename node_list::iterator;
+  using const_iterator = typename node_list::const_iterator;
+
+  explicit grid_map(const C &comp = C{},
+                    const uniquelist::grid_options &options = {})
+      : comp{comp}, options{options} {
+    if (comp.rtol < 0 || comp.atol < 0 || comp.rtol >= 1) {
+      throw std::invalid_argument("tolerance out of range");
+    }
+    if (comp.atol == 0 && comp.rtol != 0) {
+      throw std::invalid_argument("atol must be positive if rtol is not zero");
+    }
+    if (!(options.cell_width >= 2)) {
+      throw std::invalid_argument("cell_width must be at least 2");
+    }
+    // Two elements equal within the tolerance are at most `band` apart
+    // after the mapping.  A small margin is added for rounding errors.
+    band = (comp.atol == 0) ? 0.0 : (1 + 1e-9) / (1 - comp.rtol) + 1e-9;
+    width = (comp.atol == 0) ? 1.0 : band * options.cell_width;
+  }
+
+  /* Iterators */
+
+  iterator begin() noexcept { return nodes.begin(); }
+
+  const_iterator begin() const noexcept { return nodes.begin(); }
+
+  iterator end() noexcept { return nodes.end(); }
+
+  const_iterator end() const noexcept { return nodes.end(); }
+
+  /* Capacity */
+
+  bool empty() const noexcept { return nodes.empty(); }
+
+  size_t size() const noexcept { return nodes.size(); }
+
+  size_t max_size() const noexcept { return nodes.max_size(); }
+
+  /* Observers */
+
+  C key_comp() const { return comp; }
+
+  /**
+   * @brief Return the parameters of the grid
+   */
+  uniquelist::grid_options grid_options() const { return options; }
+
+  /* Lookup */
+
+  /**
+   * @brief Find a key equal to a given one within the tolerance
+   *
+   * @return Iterator to the key stored first among those equal to
+   *     `key`, or `end()` if there is no such key.
+   */
+  template <typename Q> iterator find(const Q &key) {
+    probe_type probe;
+    probe.compute(*this, key);
+    return find(probe, key);
+  }
+
+  template <typename Q> const_iterator find(const Q &key) const {
+    return const_cast<grid_map *>(this)->find(key);
+  }
+
+  template <typename Q> size_t count(const Q &key) const {
+    return find(key) != end();
+  }
+
+  /* Modifiers */
+
+  template <typename P> std::pair<iterator, bool> insert(P &&value) {
+    return try_emplace(std::forward<P>(value).first,
+                       std::forward<P>(value).second);
+  }
+
+  template <typename Q, typename... Args>
+  std::pair<iterator, bool> try_emplace(Q &&key, Args &&...args) {
+    probe_type probe;
+    probe.compute(*this, key);
+    auto it = find(probe, key);
+    if (it != nodes.end()) {
+      return {it, false};
+    }
+    return {add(probe, std::forward<Q>(key), std::forward<Args>(args)...),
+            true};
+  }
+
+  /**
+   * @brief Insert an element
+   *
+   * The elements are not sorted, and `end()` as the hint means that no
+   * key equal to `key` is in the map, as after `find` returns `end()`.
+   * Then the element is added without searching the cells again.
+   * Otherwise, this is the same as `try_emplace`.
+   */
+  template <typename Q, typename... Args>
+  iterator emplace_hint(const_iterator hint, Q &&key, Args &&...args) {
+    if (hint != nodes.end()) {
+      return std::get<0>(
+          try_emplace(std::forward<Q>(key), std::forward<Args>(args)...));
+    }
+    probe_type probe;
+    probe.compute(*this, key);
+    return add(probe, std::forward<Q>(key), std::forward<Args>(args)...);
+  }
+
+  iterator erase(const_iterator position) {
+    auto &bucket = buckets[position->hash];
+    for (auto &it : bucket) {
+      if (it == position) {
+        it = bucket.back();
+        bucket.pop_back();
+        break;
+      }
+    }
+    if (bucket.empty()) {
+      buckets.erase(position->hash);
+    }
+    return nodes.erase(position);
+  }
+
+  iterator erase(iterator position) {
+    return erase(const_iterator(position));
+  }
+
+  void clear() noexcept {
+    nodes.clear();
+    buckets.clear();
+  }
+
+private:
+  /**
+   * @brief Cells of a query and its neighbours near the boundary
+   */
+  struct probe_type {
+    /** Index of the cell of each hashed element. */
+    std::vector<std::int64_t> cells;
+    /** Pairs of an element index and the direction to its neighbour. */
+    std::vector<std::pair<size_t, std::int64_t>> boundary;
+
+    template <typename Q> void compute(const grid_map &map, const Q &key) {
+      auto n = std::min<size_t>(key.size, map.options.hashed_size);
+      auto p = detail::elements(key);
+      cells.resize(n);
+      boundary.clear();
+      for (size_t i = 0; i < n; ++i) {
+        auto u = map.transform(p[i]) / map.width;
+        auto cell = std::floor(u);
+        cells[i] = clamp(cell);
+        auto offset = (u - cell) * map.width;
+        if (offset < map.band) {
+          boundary.emplace_back(i, -1);
+        } else if (map.width - offset < map.band) {
+          boundary.emplace_back(i, 1);
+        }
+      }
+    }
+
+    /**
+     * @brief Return the hash of a cell
+     *
+     * The bits of `mask` select the elements near the boundary
+     * which are moved to the neighbouring cells.
+     */
+    size_t hash(size_t size, size_t mask) const {
+      std::uint64_t h = 0xcbf29ce484222325ULL ^ size;
+      size_t b = 0;
+      for (size_t i = 0; i < cells.size(); ++i) {
+        auto cell = cells[i];
+        if (b < boundary.size() && boundary[b].first == i) {
+          if (mask & (size_t{1} << b)) {
+            cell += boundary[b].second;
+          }
+          ++b;
+        }
+        h = (h ^ static_cast<std::uint64_t>(cell)) * 0x100000001b3ULL;
+        h ^= h >> 29;
+      }
+      return static_cast<size_t>(h);
+    }
+
+    static std::int64_t clamp(double x) noexcept {
+      constexpr double limit = 4e18;
+      if (!(x > -limit)) { // Also maps NaN to the lowest cell.
+        return -static_cast<std::int64_t>(limit);
+      } else if (x > limit) {
+        return static_cast<std::int64_t>(limit);
+      }
+      return static_cast<std::int64_t>(x);
+    }
+  };
+
+  /**
+   * @brief Add a key to its cell without searching for it
+   */
+  template <typename Q, typename... Args>
+  iterator add(const probe_type &probe, Q &&key, Args &&...args) {
+    auto hash = probe.hash(key.size, 0);
+    nodes.emplace_back(hash, counter++, std::piecewise_construct,
+                       std::forward_as_tuple(std::forward<Q>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    auto added = std::prev(nodes.end());
+    buckets[hash].push_back(added);
+    return added;
+  }
+
+  /**
+   * @brief Find a key in the cells of a probe
+   */
+  template <typename Q> iterator find(const probe_type &probe, const Q &key) {
+    iterator found = nodes.end();
+    auto n = probe.boundary.size();
+    for (size_t mask = 0; mask < (size_t{1} << n); ++mask) {
+      auto bucket = buckets.find(probe.hash(key.size, mask));
+      if (bucket == buckets.end()) {
+        continue;
+      }
+      for (auto it : bucket->second) {
+        if ((found == nodes.end() || it->order < found->order) &&
+            equal(it->first, key)) {
+          found = it;
+        }
+      }
+    }
+    return found;
+  }
+
+  /**
+   * @brief Map an element so that the tolerance becomes uniform
+   */
+  double transform(double x) const noexcept {
+    if (comp.rtol == 0) {
+      return (comp.atol == 0) ? x : x / comp.atol;
+    }
+    auto y = std::log1p(comp.rtol * std::abs(x) / comp.atol) / comp.rtol;
+    return (x < 0) ? -y : y;
+  }
+
+  template <typename Q> bool equal(const K &a, const Q &b) const {
+    return !comp(a, b) && !comp(b, a);
+  }
+
+  C comp;
+  uniquelist::grid_options options;
+  double band = 0;
+  double width = 1;
+
+  /** Elements in the order of insertion. */
+  node_list nodes{};
+
+  /** Map from the hash of a cell to the elements in the cell. */
+  std::unordered_map<size_t, std::vector<iterator>> buckets{};
+
+  /** Counter to record the order of insertion. */
+  size_t counter = 0;
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_GRID_MAP_H
@@ -0,0 +1,482 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Map of arrays equal within a distance
+ */
+
+#ifndef UNIQUELIST_KD_MAP_H
+#define UNIQUELIST_KD_MAP_H
+
+#include <algorithm> // std::nth_element, std::partition
+#include <cmath>     // std::abs, std::log
+#include <cstddef>
+#include <iterator>      // std::prev
+#include <limits>        // std::numeric_limits
+#include <list>          // std::list
+#include <stdexcept>     // std::invalid_argument
+#include <tuple>         // std::forward_as_tuple
+#include <type_traits>   // std::remove_const_t
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::pair
+#include <vector>        // std::vector
+
+#include "uniquelist/grid_map.h" // detail::elements
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Test if two arrays are within a given distance
+ *
+ * This is used as the comparison object of kd_map.  Two arrays are
+ * considered equal if they have the same size and the distance
+ * between them measured by `norm` is at most `eps`.
+ */
+struct within_distance {
+  enum norm_type { l2, linf };
+
+  double eps;
+  norm_type norm;
+
+  within_distance(double eps = 1e-6, norm_type norm = l2)
+      : eps{eps}, norm{norm} {}
+
+  /**
+   * @brief Test if two arrays of size n are within the distance
+   */
+  template <typename T>
+  bool operator()(const T *p, const T *q, size_t n) const {
+    if (norm == linf) {
+      for (size_t i = 0; i < n; ++i) {
+        if (std::abs(p[i] - q[i]) > eps) {
+          return false;
+        }
+      }
+      return true;
+    }
+    auto bound = eps * eps;
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      auto d = p[i] - q[i];
+      sum += d * d;
+      if (sum > bound) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Map of arrays equal within a distance
+ *
+ * This is a map whose keys are arrays (sized_ptr or fixed_array) and
+ * two keys are considered equal if they are within the distance given
+ * by `within_distance`.  This may be used as the underlying map of
+ * uniquelist:
+ *
+ * ```
+ * uniquelist<sized_ptr<P>, within_distance, kd_map> list{
+ *     within_distance{1e-3, within_distance::linf}};
+ * ```
+ *
+ * Keys are kept in one kd-tree for each size.  A new key is added
+ * as a leaf of the tree, and an erased key is only marked as removed
+ * since it may split the space of other keys.  A tree is rebuilt
+ * to be balanced when it gets too deep or more than half of its
+ * nodes are removed, so that the lookup takes logarithmic time on
+ * average if `eps` is small relative to the spread of the keys.
+ *
+ * If a query is within the distance of more than one stored key,
+ * the key stored first is returned.
+ *
+ * Iterating over this map visits the elements in the order they are
+ * inserted, not in the increasing order.
+ */
+template <typename K, typename V, typename C = within_distance> class kd_map {
+
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  /**
+   * @brief Node keeping a key-value pair and its position in a tree
+   */
+  struct node : std::pair<const K, V> {
+    template <typename... Args>
+    node(size_t order, Args &&...args)
+        : std::pair<const K, V>(std::forward<Args>(args)...), order{order} {}
+
+    size_t order;
+    size_t slot = npos;
+  };
+
+  using node_list = std::list<node>;
+
+  using element_type = std::remove_const_t<std::remove_reference_t<decltype(
+      detail::elements(std::declval<const K &>())[0])>>;
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using key_compare = C;
+  using size_type = size_t;
+  using iterator = typename node_list::iterator;
+  using const_iterator = typename node_list::const_iterator;
+
+  explicit kd_map(const C &comp = C{}) : comp{comp} {
+    if (!(comp.eps >= 0)) {
+      throw std::invalid_argument("eps must be nonnegative");
+    }
+  }
+
+  /* Iterators */
+
+  iterator begin() noexcept { return nodes.begin(); }
+
+  const_iterator begin() const noexcept { return nodes.begin(); }
+
+  iterator end() noexcept { return nodes.end(); }
+
+  const_iterator end() const noexcept { return nodes.end(); }
+
+  /* Capacity */
+
+  bool empty() const noexcept { return nodes.empty(); }
+
+  size_t size() const noexcept { return nodes.size(); }
+
+  size_t max_size() const noexcept { return nodes.max_size(); }
+
+  /* Observers */
+
+  C key_comp() const { return comp; }
+
+  /* Lookup */
+
+  /**
+   * @brief Find a key within the distance of a given one
+   *
+   * @return Iterator to the key stored first among those within
+   *     the distance, or `end()` if there is no such key.
+   */
+  template <typename Q> iterator find(const Q &key) {
+    auto tree = trees.find(key.size);
+    if (tree == trees.end()) {
+      return nodes.end();
+    }
+    return tree->second.find(comp, detail::elements(key), nodes.end());
+  }
+
+  template <typename Q> const_iterator find(const Q &key) const {
+    return const_cast<kd_map *>(this)->find(key);
+  }
+
+  template <typename Q> size_t count(const Q &key) const {
+    return find(key) != end();
+  }
+
+  /* Modifiers */
+
+  template <typename P> std::pair<iterator, bool> insert(P &&value) {
+    return try_emplace(std::forward<P>(value).first,
+                       std::forward<P>(value).second);
+  }
+
+  template <typename Q, typename... Args>
+  std::pair<iterator, bool> try_emplace(Q &&key, Args &&...args) {
+    auto it = find(key);
+    if (it != nodes.end()) {
+      return {it, false};
+    }
+    auto size = key.size;
+    nodes.emplace_back(counter++, std::piecewise_construct,
+                       std::forward_as_tuple(std::forward<Q>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    auto added = std::prev(nodes.end());
+    trees[size].insert(added);
+    return {added, true};
+  }
+
+  /**
+   * @brief Insert an element
+   *
+   * The hint is ignored since the elements are not sorted.
+   */
+  template <typename Q, typename... Args>
+  iterator emplace_hint(const_iterator hint, Q &&key, Args &&...args) {
+    (void)hint;
+    return std::get<0>(
+        try_emplace(std::forward<Q>(key), std::forward<Args>(args)...));
+  }
+
+  iterator erase(const_iterator position) {
+    auto tree = trees.find(position->first.size);
+    tree->second.erase(position->slot);
+    if (tree->second.empty()) {
+      trees.erase(tree);
+    }
+    return nodes.erase(position);
+  }
+
+  iterator erase(iterator position) {
+    return erase(const_iterator(position));
+  }
+
+  void clear() noexcept {
+    nodes.clear();
+    trees.clear();
+  }
+
+private:
+  /**
+   * @brief kd-tree of keys of the same size
+   *
+   * Each node of the tree is a key and splits the space by its
+   * element at the index `depth % size`.  Keys whose element is
+   * smaller go to the left subtree and the others go to the right.
+   *
+   * The tree is kept balanced in the same way as a scapegoat tree.
+   * When a new leaf is deeper than `log(n) / log(1 / alpha)`, the
+   * subtree rooted at the lowest unbalanced ancestor is rebuilt.
+   */
+  struct tree_type {
+    /**
+     * @brief Node of the tree
+     *
+     * The split element is copied since the key of a removed node
+     * is released.
+     */
+    struct tree_node {
+      iterator item;
+      element_type split;
+      size_t left = npos;
+      size_t right = npos;
+      size_t size = 1;
+      bool alive = true;
+    };
+
+    static constexpr double alpha = 0.7;
+
+    /** Nodes of the tree.  Slots of rebuilt subtrees are not reused. */
+    std::vector<tree_node> tree_nodes{};
+    size_t root = npos;
+    /** Number of keys which are not removed. */
+    size_t live = 0;
+    /** Number of nodes reachable from the root. */
+    size_t used = 0;
+    /** Size of the keys. */
+    size_t dim = 0;
+
+    bool empty() const noexcept { return live == 0; }
+
+    size_t subtree_size(size_t slot) const noexcept {
+      return (slot == npos) ? 0 : tree_nodes[slot].size;
+    }
+
+    static auto point(const tree_node &n) noexcept {
+      return detail::elements(n.item->first);
+    }
+
+    /**
+     * @brief Add a key as a leaf
+     */
+    void insert(iterator item) {
+      dim = item->first.size;
+      auto p = detail::elements(item->first);
+      std::vector<size_t> path;
+      auto cursor = root;
+      while (cursor != npos) {
+        path.push_back(cursor);
+        auto &n = tree_nodes[cursor];
+        auto k = (dim > 0) ? (path.size() - 1) % dim : 0;
+        cursor = (dim > 0 && p[k] < n.split) ? n.left : n.right;
+      }
+      auto slot = tree_nodes.size();
+      auto k = (dim > 0) ? path.size() % dim : 0;
+      tree_nodes.push_back(tree_node{item, (dim > 0) ? p[k] : element_type{}});
+      item->slot = slot;
+      ++live;
+      ++used;
+      if (root == npos) {
+        root = slot;
+        return;
+      }
+      for (auto i : path) {
+        ++tree_nodes[i].size;
+      }
+      auto &parent = tree_nodes[path.back()];
+      auto pk = (dim > 0) ? (path.size() - 1) % dim : 0;
+      ((dim > 0 && p[pk] < parent.split) ? parent.left : parent.right) = slot;
+      if (static_cast<double>(path.size()) <=
+          std::log(static_cast<double>(used)) / std::log(1 / alpha) + 1) {
+        return;
+      }
+      // Find the lowest ancestor whose subtree is unbalanced.
+      for (auto i = path.size(); i-- > 0;) {
+        auto &n = tree_nodes[path[i]];
+        auto larger = std::max(subtree_size(n.left), subtree_size(n.right));
+        if (larger > alpha * n.size) {
+          rebuild(path, i);
+          break;
+        }
+      }
+      // Release the slots of the rebuilt subtrees.
+      if (2 * used < tree_nodes.size()) {
+        rebuild({root}, 0);
+      }
+    }
+
+    /**
+     * @brief Mark a key as removed
+     */
+    void erase(size_t slot) {
+      tree_nodes[slot].alive = false;
+      --live;
+      if (live == 0) {
+        tree_nodes.clear();
+        root = npos;
+        used = 0;
+      } else if (2 * live < used || 2 * used < tree_nodes.size()) {
+        rebuild({root}, 0);
+      }
+    }
+
+    /**
+     * @brief Rebuild the subtree rooted at `path[i]`
+     *
+     * `path` is the path from the root.  Removed keys in the subtree
+     * are dropped.  If the whole tree is rebuilt, unused slots are
+     * released as well.
+     */
+    void rebuild(const std::vector<size_t> &path, size_t i) {
+      std::vector<std::pair<iterator, const element_type *>> items;
+      collect(path[i], items);
+      auto removed = tree_nodes[path[i]].size - items.size();
+      used -= removed;
+      for (size_t j = 0; j < i; ++j) {
+        tree_nodes[path[j]].size -= removed;
+      }
+      if (i == 0) {
+        tree_nodes.clear();
+        tree_nodes.reserve(items.size());
+        root = build(items.begin(), items.end(), 0);
+        return;
+      }
+      auto subtree = build(items.begin(), items.end(), i);
+      auto &parent = tree_nodes[path[i - 1]];
+      (parent.left == path[i] ? parent.left : parent.right) = subtree;
+    }
+
+    /**
+     * @brief Collect the keys in a subtree which are not removed
+     *
+     * The keys are paired with the pointers to their elements.
+     */
+    template <typename Items>
+    void collect(size_t slot, Items &items) const {
+      std::vector<size_t> stack{slot};
+      while (!stack.empty()) {
+        auto &n = tree_nodes[stack.back()];
+        stack.pop_back();
+        if (n.alive) {
+          items.emplace_back(n.item, point(n));
+        }
+        if (n.left != npos) {
+          stack.push_back(n.left);
+        }
+        if (n.right != npos) {
+          stack.push_back(n.right);
+        }
+      }
+    }
+
+    template <typename It> size_t build(It first, It last, size_t depth) {
+      if (first == last) {
+        return npos;
+      }
+      auto middle = first + (last - first) / 2;
+      if (dim > 0) {
+        auto k = depth % dim;
+        using item_type = typename std::iterator_traits<It>::value_type;
+        std::nth_element(first, middle, last,
+                         [k](const item_type &a, const item_type &b) {
+                           return a.second[k] < b.second[k];
+                         });
+        // Keys equal to the median in the split element must go right.
+        auto pivot = middle->second[k];
+        auto split = std::partition(first, middle, [&](const item_type &a) {
+          return a.second[k] < pivot;
+        });
+        std::iter_swap(split, middle);
+        middle = split;
+      }
+      auto slot = tree_nodes.size();
+      auto split = (dim > 0) ? middle->second[depth % dim] : element_type{};
+      tree_nodes.push_back(tree_node{middle->first, split});
+      middle->first->slot = slot;
+      auto left = build(first, middle, depth + 1);
+      auto right = build(std::next(middle), last, depth + 1);
+      auto &n = tree_nodes[slot];
+      n.left = left;
+      n.right = right;
+      n.size = 1 + subtree_size(left) + subtree_size(right);
+      return slot;
+    }
+
+    /**
+     * @brief Find the key stored first within the distance
+     */
+    template <typename T>
+    iterator find(const C &comp, const T *q, iterator none) const {
+      iterator found = none;
+      if (root == npos) {
+        return found;
+      }
+      std::vector<std::pair<size_t, size_t>> stack{{root, 0}};
+      while (!stack.empty()) {
+        auto [cursor, depth] = stack.back();
+        stack.pop_back();
+        auto &n = tree_nodes[cursor];
+        // The split element of a node is its own element at index k,
+        // so the distance is computed only if the split is close.
+        auto k = (dim > 0) ? depth % dim : 0;
+        auto close = (dim == 0) || std::abs(q[k] - n.split) <= comp.eps;
+        if (close && n.alive &&
+            (found == none || n.item->order < found->order) &&
+            comp(point(n), q, dim)) {
+          found = n.item;
+        }
+        if (dim == 0) {
+          if (n.right != npos) {
+            stack.emplace_back(n.right, depth + 1);
+          }
+          continue;
+        }
+        if (n.left != npos && q[k] - comp.eps < n.split) {
+          stack.emplace_back(n.left, depth + 1);
+        }
+        if (n.right != npos && q[k] + comp.eps >= n.split) {
+          stack.emplace_back(n.right, depth + 1);
+        }
+      }
+      return found;
+    }
+  };
+
+  C comp;
+
+  /** Elements in the order of insertion. */
+  node_list nodes{};
+
+  /** Map from the size of keys to the tree of them. */
+  std::unordered_map<size_t, tree_type> trees{};
+
+  /** Counter to record the order of insertion. */
+  size_t counter = 0;
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_KD_MAP_H
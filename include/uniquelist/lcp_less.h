@@ -0,0 +1,149 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Search for arrays which skips the prefixes known to be equal
+ */
+
+#ifndef UNIQUELIST_LCP_LESS_H
+#define UNIQUELIST_LCP_LESS_H
+
+#include <algorithm> // std::min
+#include <cstddef>
+#include <memory>  // std::shared_ptr
+#include <utility> // std::move
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Array searched for by lcp_less
+ *
+ * This wraps a sized_ptr and records the lengths of the longest common
+ * prefixes (LCP) with the lower and upper bounds found so far in
+ * a search.  A probe must be used for only one search, such as one
+ * call of `isin` or `push_back_with_hook`.
+ */
+template <typename P> struct lcp_probe {
+  sized_ptr<P> key;
+
+  /** LCP with the largest key found to be smaller than the probe. */
+  mutable size_t lo = 0;
+
+  /** LCP with the smallest key found to be not smaller. */
+  mutable size_t hi = 0;
+
+  /** Return the length of the prefix shared by the keys searched. */
+  size_t start() const noexcept { return std::min(lo, hi); }
+};
+
+/**
+ * @brief Create a probe of lcp_less
+ */
+template <typename P> auto as_lcp_probe(sized_ptr<P> key) {
+  return lcp_probe<P>{std::move(key)};
+}
+
+/**
+ * @brief Compare arrays skipping the prefixes known to be equal
+ *
+ * This compares sized_ptrs in the same order as `operator<` of
+ * sized_ptr.  When a key is compared with an lcp_probe, the comparison
+ * starts from the shorter of the LCPs between the probe and the lower
+ * and upper bounds found so far.  In a search tree, all keys between
+ * the two bounds share that prefix with the probe, as in string
+ * B-trees.  Searching a tree of n arrays of size d then reads
+ * O(log n + d) elements when they share long prefixes, instead of
+ * O(d log n).  `stats` counts the elements read.
+ *
+ * ```
+ * uniquelist<sized_ptr<P>, lcp_less> list;
+ * list.push_back_with_hook(as_lcp_probe(a), [](const auto &x) {
+ *   return deepcopy(x.key);
+ * });
+ * ```
+ *
+ * The elements are compared exactly, since the prefixes of keys
+ * equal within a tolerance are not shared by the keys in between.
+ */
+struct lcp_less {
+  using is_transparent = void;
+  using is_exact = void;
+
+  /** Statistics, which are recorded if this is not null. */
+  std::shared_ptr<depth_stats> stats{};
+
+  template <typename P, typename Q>
+  bool operator()(const sized_ptr<P> &a, const sized_ptr<Q> &b) const {
+    return a < b;
+  }
+
+  template <typename P, typename Q>
+  bool operator()(const sized_ptr<P> &a, const lcp_probe<Q> &b) const {
+    size_t lcp;
+    auto c = compare(a, b.key, b.start(), lcp);
+    // a < b makes a lower bound and otherwise an upper bound.
+    (c < 0 ? b.lo : b.hi) = lcp;
+    return c < 0;
+  }
+
+  template <typename P, typename Q>
+  bool operator()(const lcp_probe<P> &a, const sized_ptr<Q> &b) const {
+    size_t lcp;
+    auto c = compare(b, a.key, a.start(), lcp);
+    // a < b makes b an upper bound and otherwise a lower bound.
+    (c > 0 ? a.hi : a.lo) = lcp;
+    return c > 0;
+  }
+
+private:
+  /**
+   * @brief Compare two arrays whose first `start` elements are equal
+   *
+   * @param [out] lcp Length of the longest common prefix.
+   *
+   * @return Negative, zero or positive if `a` is smaller, equivalent
+   *     or larger than `b`, respectively.
+   */
+  template <typename P, typename Q>
+  int compare(const sized_ptr<P> &a, const sized_ptr<Q> &b, size_t start,
+              size_t &lcp) const {
+    if (a.size != b.size) {
+      lcp = 0;
+      record(0);
+      return (a.size < b.size) ? -1 : 1;
+    }
+    auto p = a.ptr.get();
+    auto q = b.ptr.get();
+    size_t i = start;
+    while (i < a.size && p[i] == q[i]) {
+      ++i;
+    }
+    lcp = i;
+    int result = 0;
+    for (; i < a.size; ++i) {
+      if (p[i] < q[i]) {
+        result = -1;
+        break;
+      } else if (q[i] < p[i]) {
+        result = 1;
+        break;
+      }
+    }
+    record(std::min(i + 1, a.size) - start);
+    return result;
+  }
+
+  void record(size_t scanned) const noexcept {
+    if (stats) {
+      ++stats->comparisons;
+      stats->scanned += scanned;
+    }
+  }
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_LCP_LESS_H
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Loop split over threads
+ */
+
+#ifndef UNIQUELIST_PARALLEL_H
+#define UNIQUELIST_PARALLEL_H
+
+#include <algorithm> // std::min
+#include <cstddef>
+#include <exception>    // std::exception_ptr
+#include <mutex>        // std::mutex
+#include <system_error> // std::system_error
+#include <thread>       // std::thread
+#include <vector>
+
+namespace uniquelist {
+
+/**
+ * @brief Return the number of threads to use
+ *
+ * If `threads` is 0, the number of hardware threads is returned.
+ */
+inline unsigned resolve_threads(unsigned threads) noexcept {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  return (threads > 0) ? threads : 1;
+}
+
+/**
+ * @brief Call a function on chunks of a range in parallel
+ *
+ * This splits [0, n) into at most `threads` chunks of at least `grain`
+ * items and calls `f(begin, end)` for each of them, one chunk on the
+ * calling thread and the others on new threads.  If `f` throws, the
+ * first exception is rethrown after all chunks finish.
+ *
+ * @param [in] n Size of the range.
+ * @param [in] grain Minimum number of items in a chunk.
+ * @param [in] f Function called with the bounds of a chunk.
+ * @param [in] threads Number of threads.  0 means the number of
+ *     hardware threads.
+ */
+template <typename F>
+void parallel_for(size_t n, size_t grain, const F &f, unsigned threads = 0) {
+  if (n == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks =
+      std::min<size_t>(resolve_threads(threads), (n + grain - 1) / grain);
+  if (chunks <= 1) {
+    f(size_t{0}, n);
+    return;
+  }
+  std::exception_ptr error;
+  std::mutex mutex;
+  auto run = [&](size_t c) {
+    try {
+      f(n * c / chunks, n * (c + 1) / chunks);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  size_t c = 1;
+  try {
+    for (; c < chunks; ++c) {
+      workers.emplace_back(run, c);
+    }
+  } catch (const std::system_error &) {
+    // Run the remaining chunks here if no more threads can be created.
+  }
+  for (auto rest = c; rest < chunks; ++rest) {
+    run(rest);
+  }
+  run(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_PARALLEL_H
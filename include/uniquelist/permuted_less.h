@@ -0,0 +1,178 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Comparison of arrays in a permuted order of coordinates
+ */
+
+#ifndef UNIQUELIST_PERMUTED_LESS_H
+#define UNIQUELIST_PERMUTED_LESS_H
+
+#include <algorithm> // std::sort, std::stable_sort
+#include <cstddef>
+#include <iterator> // std::next
+#include <map>      // std::map
+#include <memory>   // std::shared_ptr
+#include <numeric>  // std::iota
+#include <utility>  // std::move
+#include <vector>
+
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Compare arrays visiting the coordinates in a given order
+ *
+ * This compares sized_ptrs as `Compare` does but the elements are
+ * read in the order of `order`, instead of 0, 1, ..., n - 1.  If the
+ * first coordinates are nearly constant over the arrays, putting
+ * them last lets most comparisons exit after a few elements.
+ * `order` is used only for the arrays of the same size as it and the
+ * other arrays are compared in the usual order.
+ *
+ * The order of the keys depends on `order`, which is therefore
+ * immutable.  To use another order, a list is rebuilt with a new
+ * comparator, as `adapt_order` does.  If `stats` is set, the number
+ * of elements read is counted.
+ */
+template <typename Compare = strictly_less> struct permuted_less {
+  using is_transparent = void;
+
+  Compare compare{};
+  std::shared_ptr<const std::vector<size_t>> order{};
+  std::shared_ptr<depth_stats> stats{};
+
+  /**
+   * @brief Return the comparison object with the tolerance times f
+   *
+   * The statistics are not shared with the result.
+   */
+  permuted_less widened(double f) const {
+    return permuted_less{compare.widened(f), order};
+  }
+
+  template <typename P, typename Q>
+  bool operator()(const sized_ptr<P> &a, const sized_ptr<Q> &b) const {
+    if (a.size != b.size) {
+      record(0);
+      return a.size < b.size;
+    }
+    auto p = a.ptr.get();
+    auto q = b.ptr.get();
+    auto permuted = order && order->size() == a.size;
+    auto index = permuted ? order->data() : nullptr;
+    for (size_t k = 0; k < a.size; ++k) {
+      auto i = permuted ? index[k] : k;
+      if (compare(p[i], q[i])) {
+        record(k + 1);
+        return true;
+      } else if (compare(q[i], p[i])) {
+        record(k + 1);
+        return false;
+      }
+    }
+    record(a.size);
+    return false;
+  }
+
+private:
+  void record(size_t scanned) const noexcept {
+    if (stats) {
+      ++stats->comparisons;
+      stats->scanned += scanned;
+    }
+  }
+};
+
+/**
+ * @brief Order coordinates by how well they tell arrays apart
+ *
+ * For each coordinate, the values of the sampled arrays are grouped
+ * into those equal under `compare` and the coordinate is scored by
+ * the probability that two random arrays fall in different groups
+ * (the Gini impurity).  The coordinates are returned in the decreasing
+ * order of the scores, with ties kept in the original order.
+ *
+ * @param [in] rows Pointers to the sampled arrays.
+ * @param [in] size Size of the arrays.
+ * @param [in] compare Comparison of the elements.
+ */
+template <typename T, typename Compare>
+std::vector<size_t> discriminative_order(const std::vector<const T *> &rows,
+                                         size_t size, const Compare &compare) {
+  std::vector<double> score(size, 0.0);
+  std::vector<T> values(rows.size());
+  auto m = static_cast<double>(rows.size());
+  for (size_t i = 0; i < size && !rows.empty(); ++i) {
+    for (size_t r = 0; r < rows.size(); ++r) {
+      values[r] = rows[r][i];
+    }
+    std::sort(values.begin(), values.end());
+    double same = 0;
+    size_t first = 0;
+    for (size_t r = 1; r <= values.size(); ++r) {
+      if (r == values.size() || compare(values[first], values[r])) {
+        auto c = static_cast<double>(r - first);
+        same += c * c;
+        first = r;
+      }
+    }
+    score[i] = 1.0 - same / (m * m);
+  }
+  std::vector<size_t> order(size);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return score[a] > score[b]; });
+  return order;
+}
+
+/**
+ * @brief Update the order of coordinates of a list from its arrays
+ *
+ * This samples up to `sample_size` arrays evenly in the order of
+ * addition, takes those of the most common size and computes their
+ * `discriminative_order`.  If it differs from the current one, the
+ * list is rebuilt with the new order.  The statistics are kept.
+ *
+ * @return true if the order is updated.
+ */
+template <typename P, typename C, template <typename...> class Map>
+bool adapt_order(uniquelist<sized_ptr<P>, permuted_less<C>, Map> &list,
+                 size_t sample_size = 1024) {
+  if (list.empty() || sample_size == 0) {
+    return false;
+  }
+  using element_type = std::remove_const_t<
+      std::remove_extent_t<typename P::element_type>>;
+  auto step = std::max<size_t>(1, list.size() / sample_size);
+  std::map<size_t, std::vector<const element_type *>> samples;
+  auto it = std::begin(list);
+  for (size_t i = 0; i < list.size(); i += step) {
+    samples[it->size].push_back(it->ptr.get());
+    if (i + step < list.size()) {
+      std::advance(it, step);
+    }
+  }
+  auto common = samples.begin();
+  for (auto s = samples.begin(); s != samples.end(); ++s) {
+    if (s->second.size() > common->second.size()) {
+      common = s;
+    }
+  }
+  auto comp = list.key_comp();
+  auto order =
+      discriminative_order(common->second, common->first, comp.compare);
+  if (comp.order && *comp.order == order) {
+    return false;
+  }
+  comp.order = std::make_shared<const std::vector<size_t>>(std::move(order));
+  list.rebuild(comp);
+  return true;
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_PERMUTED_LESS_H
@@ -0,0 +1,180 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Sized ptr with a copy of its leading elements
+ */
+
+#ifndef UNIQUELIST_PREFIXED_PTR_H
+#define UNIQUELIST_PREFIXED_PTR_H
+
+#include <algorithm> // std::min
+#include <cstddef>
+#include <memory>      // std::shared_ptr
+#include <type_traits> // std::remove_const_t
+#include <utility>     // std::move
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Sized ptr with a copy of its leading elements
+ *
+ * This is a sized_ptr which additionally keeps a copy of the first
+ * M elements inline.  When it is used as a key of uniquelist, the copy
+ * lives in the node of the underlying map next to the size, so that
+ * `prefix_less` can often compare two keys without dereferencing
+ * `ptr`.
+ *
+ * The copy is exact, so that the comparison of the prefix gives the
+ * same result as the comparison of the original elements under any
+ * tolerance.  If the size is smaller than M, the remaining entries are
+ * value-initialised and never read.
+ */
+template <typename P, size_t M = 2> struct prefixed_ptr : sized_ptr<P> {
+  using element_type =
+      std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
+
+  static constexpr size_t prefix_size = M;
+
+  element_type prefix[M];
+};
+
+/**
+ * @brief Create a prefixed_ptr from a sized_ptr
+ *
+ * This copies the first M elements of `p` to the prefix.
+ * The memory block pointed by `p` is shared, not copied.
+ */
+template <size_t M = 2, typename P> auto with_prefix(sized_ptr<P> p) {
+  prefixed_ptr<P, M> out{};
+  auto n = std::min(p.size, M);
+  std::copy(p.ptr.get(), p.ptr.get() + n, out.prefix);
+  out.size = p.size;
+  out.ptr = std::move(p.ptr);
+  return out;
+}
+
+/**
+ * @brief Deepcopy a prefixed_ptr
+ *
+ * This deepcopies the memory block while the prefix is copied as is.
+ */
+template <typename P, size_t M> auto deepcopy(const prefixed_ptr<P, M> &p) {
+  auto out = p;
+  static_cast<sized_ptr<P> &>(out) =
+      deepcopy(static_cast<const sized_ptr<P> &>(p));
+  return out;
+}
+
+/**
+ * @brief Statistics of prefix_less
+ *
+ * `comparisons` is the number of comparisons made and `resolved` is
+ * the number of them resolved by the sizes and the prefixes without
+ * reading the memory blocks.
+ */
+struct prefix_stats {
+  size_t comparisons = 0;
+  size_t resolved = 0;
+
+  /**
+   * @brief Return the ratio of comparisons resolved by the prefixes
+   */
+  double hit_rate() const noexcept {
+    return comparisons > 0 ? static_cast<double>(resolved) / comparisons : 0.0;
+  }
+
+  /**
+   * @brief Reset the counters
+   */
+  void reset() noexcept {
+    comparisons = 0;
+    resolved = 0;
+  }
+};
+
+/**
+ * @brief Compare two prefixed_ptrs using their prefixes first
+ *
+ * This gives the same result as `Compare` applied to the sized_ptrs,
+ * where `Compare` is either `strictly_less` or `std::less<>`.
+ * The sizes and the prefixes are compared first and only when they
+ * cannot decide the order the remaining elements are read.
+ *
+ * If `stats` is set, the number of comparisons and those resolved
+ * without reading the memory blocks are counted.  Since uniquelist
+ * keeps a copy of the comparator, the statistics are shared through
+ * a shared pointer:
+ *
+ * ```
+ * auto stats = std::make_shared<prefix_stats>();
+ * uniquelist<prefixed_ptr<P>, prefix_less<>> list{prefix_less<>{{}, stats}};
+ * ...
+ * stats->hit_rate();
+ * ```
+ */
+template <typename Compare = strictly_less> struct prefix_less {
+  Compare compare{};
+  std::shared_ptr<prefix_stats> stats{};
+
+  /**
+   * @brief Return the comparison object with the tolerance times f
+   *
+   * The statistics are not shared with the result.
+   */
+  prefix_less widened(double f) const {
+    return prefix_less{compare.widened(f)};
+  }
+
+  template <typename P, typename Q, size_t M>
+  bool operator()(const prefixed_ptr<P, M> &a,
+                  const prefixed_ptr<Q, M> &b) const {
+    auto result = compare_prefix(a, b);
+    if (stats) {
+      ++stats->comparisons;
+      stats->resolved += (result != undecided);
+    }
+    if (result != undecided) {
+      return result == less;
+    }
+    auto p = a.ptr.get() + M;
+    auto q = b.ptr.get() + M;
+    for (size_t i = M; i < a.size; ++i, ++p, ++q) {
+      if (compare(*p, *q)) {
+        return true;
+      } else if (compare(*q, *p)) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+private:
+  enum prefix_result { less, not_less, undecided };
+
+  template <typename P, typename Q, size_t M>
+  prefix_result compare_prefix(const prefixed_ptr<P, M> &a,
+                               const prefixed_ptr<Q, M> &b) const {
+    if (a.size < b.size) {
+      return less;
+    } else if (a.size > b.size) {
+      return not_less;
+    }
+    auto n = std::min(a.size, M);
+    for (size_t i = 0; i < n; ++i) {
+      if (compare(a.prefix[i], b.prefix[i])) {
+        return less;
+      } else if (compare(b.prefix[i], a.prefix[i])) {
+        return not_less;
+      }
+    }
+    return (a.size <= M) ? not_less : undecided;
+  }
+};
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_PREFIXED_PTR_H
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * LSD radix sort of numbers
+ */
+
+#ifndef UNIQUELIST_RADIX_SORT_H
+#define UNIQUELIST_RADIX_SORT_H
+
+#include <array>
+#include <cmath> // std::isnan
+#include <cstddef>
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <type_traits>
+#include <utility> // std::pair
+#include <vector>
+
+namespace uniquelist {
+
+/**
+ * @brief Order of numbers in which NaN is larger than the others
+ *
+ * NaN is equal to NaN, so that it can be a key as other numbers.
+ * This is the order in which `radix_sort` sorts the numbers.
+ */
+struct scalar_less {
+  using is_exact = void;
+
+  template <typename T> bool operator()(T a, T b) const noexcept {
+    if constexpr (std::is_floating_point<T>::value) {
+      if (std::isnan(b)) {
+        return !std::isnan(a);
+      } else if (std::isnan(a)) {
+        return false;
+      }
+    }
+    return a < b;
+  }
+};
+
+/**
+ * @brief Map a number to an unsigned integer in the same order
+ *
+ * Two numbers are mapped to the same integer if and only if they are
+ * equal under `scalar_less`.  Signed integers are offset by flipping
+ * the sign bit.
+ */
+template <typename T> auto radix_key(T x) noexcept {
+  static_assert(std::is_integral<T>::value, "expected an integer");
+  using U = std::make_unsigned_t<T>;
+  auto u = static_cast<U>(x);
+  if constexpr (std::is_signed<T>::value) {
+    u ^= U{1} << (8 * sizeof(U) - 1);
+  }
+  return u;
+}
+
+/**
+ * @brief Map a double to an unsigned integer in the same order
+ *
+ * The bits of a negative number are inverted and the sign bit of
+ * a positive number is set.  -0.0 is mapped as 0.0 and NaN to the
+ * largest integer.
+ */
+inline std::uint64_t radix_key(double x) noexcept {
+  if (std::isnan(x)) {
+    return ~std::uint64_t{0};
+  }
+  if (x == 0) {
+    x = 0.0;
+  }
+  std::uint64_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  constexpr auto sign = std::uint64_t{1} << 63;
+  return (u & sign) ? ~u : (u | sign);
+}
+
+/**
+ * @brief Compute the permutation which sorts unsigned integers
+ *
+ * The keys are sorted stably by one pass of counting sort per byte,
+ * starting from the least significant byte.  The counts of all bytes
+ * are taken in one pass and a byte shared by all keys is skipped.
+ *
+ * @param [in] n Number of keys.
+ * @param [in] keys Keys.  size: n
+ * @param [out] order Positions of the keys in the sorted order, so
+ *     that `keys[order[0]] <= keys[order[1]] <= ...`.  size: n
+ */
+template <typename K, typename U>
+void radix_sort(size_t n, const K *keys, U *order) {
+  static_assert(std::is_unsigned<K>::value, "expected unsigned keys");
+  if (n == 0) {
+    return;
+  }
+  constexpr size_t passes = sizeof(K);
+  std::vector<std::array<size_t, 256>> count(passes);
+  for (auto &c : count) {
+    c.fill(0);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t p = 0; p < passes; ++p) {
+      ++count[p][(keys[i] >> (8 * p)) & 0xff];
+    }
+  }
+  std::vector<std::pair<K, U>> a(n), b(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = {keys[i], static_cast<U>(i)};
+  }
+  for (size_t p = 0; p < passes; ++p) {
+    auto &c = count[p];
+    if (c[(keys[0] >> (8 * p)) & 0xff] == n) {
+      continue;
+    }
+    size_t sum = 0;
+    for (auto &x : c) {
+      sum += x;
+      x = sum - x;
+    }
+    for (const auto &x : a) {
+      b[c[(x.first >> (8 * p)) & 0xff]++] = x;
+    }
+    a.swap(b);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    order[i] = a[i].second;
+  }
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_RADIX_SORT_H
@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Sized ptr compared up to a positive scale factor
+ */
+
+#ifndef UNIQUELIST_SCALED_PTR_H
+#define UNIQUELIST_SCALED_PTR_H
+
+#include <cmath> // std::abs
+#include <cstddef>
+#include <functional>  // std::less
+#include <type_traits> // std::remove_const_t
+#include <utility>     // std::move
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Rule to choose the scale factor of an array
+ *
+ * `max_abs` scales an array so that the largest absolute value
+ * becomes 1 and `first_nonzero` so that the absolute value of the
+ * first nonzero element becomes 1.  In both cases the factor is
+ * positive and the signs of the elements are kept, since scaling
+ * a constraint `a x <= b` by a negative number reverses it.
+ */
+enum class scaling { max_abs, first_nonzero };
+
+/**
+ * @brief Sized ptr compared up to a positive scale factor
+ *
+ * This is a sized_ptr which additionally keeps a positive scale
+ * factor.  The memory block keeps the original elements and
+ * `ptr[i] / scale` is the i-th element of the canonical array.
+ * Two scaled_ptrs are compared by their canonical arrays, so that
+ * arrays which differ by a positive factor are considered equal.
+ * The canonical arrays are computed element by element during
+ * the comparison and never stored.
+ *
+ * Since the canonical elements are rounded, the arrays should be
+ * compared with a tolerance by `strictly_less`.
+ */
+template <typename P> struct scaled_ptr : sized_ptr<P> {
+  double scale = 1.0;
+
+  /**
+   * @brief Compare the canonical arrays in the shortlex order
+   */
+  template <typename Q>
+  friend bool operator<(const scaled_ptr<P> &l, const scaled_ptr<Q> &r) {
+    using element_type =
+        std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
+    return scaled_less(std::less<element_type>{}, l, r);
+  }
+};
+
+/**
+ * @brief Compute the scale factor of an array
+ *
+ * @return Positive scale factor.  If the array has no nonzero
+ *     elements, 1 is returned.
+ */
+template <typename T>
+double compute_scale(const T *p, size_t n, scaling mode = scaling::max_abs) {
+  double scale = 0;
+  if (mode == scaling::max_abs) {
+    for (size_t i = 0; i < n; ++i) {
+      double x = std::abs(static_cast<double>(p[i]));
+      if (x > scale) {
+        scale = x;
+      }
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      if (p[i] != 0) {
+        scale = std::abs(static_cast<double>(p[i]));
+        break;
+      }
+    }
+  }
+  return (scale > 0) ? scale : 1.0;
+}
+
+/**
+ * @brief Create a scaled_ptr from a sized_ptr
+ *
+ * This computes the scale factor of `p`.  The memory block pointed
+ * by `p` is shared, not copied or normalised.
+ */
+template <typename P>
+auto with_scale(sized_ptr<P> p, scaling mode = scaling::max_abs) {
+  scaled_ptr<P> out{};
+  out.scale = compute_scale(p.ptr.get(), p.size, mode);
+  out.size = p.size;
+  out.ptr = std::move(p.ptr);
+  return out;
+}
+
+/**
+ * @brief Deepcopy a scaled_ptr
+ *
+ * This deepcopies the memory block while the scale is copied as is.
+ */
+template <typename P> auto deepcopy(const scaled_ptr<P> &p) {
+  auto out = p;
+  static_cast<sized_ptr<P> &>(out) =
+      deepcopy(static_cast<const sized_ptr<P> &>(p));
+  return out;
+}
+
+/**
+ * @brief Compare the canonical arrays of two scaled_ptrs
+ *
+ * This compares the sizes first.  If they are the same, the canonical
+ * elements are compared one by one using `less`.  They are computed
+ * by multiplying the inverse of the scale, which is exact if the scale
+ * is a power of 2.
+ */
+template <typename L, typename P, typename Q>
+bool scaled_less(const L &less, const scaled_ptr<P> &a,
+                 const scaled_ptr<Q> &b) {
+  if (a.size != b.size) {
+    return a.size < b.size;
+  }
+  auto p = a.ptr.get();
+  auto q = b.ptr.get();
+  auto s = 1.0 / a.scale;
+  auto t = 1.0 / b.scale;
+  for (size_t i = 0; i < a.size; ++i) {
+    auto x = p[i] * s;
+    auto y = q[i] * t;
+    if (less(x, y)) {
+      return true;
+    } else if (less(y, x)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Compare the canonical arrays with a tolerance
+ *
+ * This is called by `strictly_less`.
+ */
+template <typename P, typename Q>
+bool tolerant_less(const strictly_less &less, const scaled_ptr<P> &a,
+                   const scaled_ptr<Q> &b) {
+  return scaled_less(less, a, b);
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_SCALED_PTR_H
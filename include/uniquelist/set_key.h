@@ -0,0 +1,237 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Set of integers in the canonical form
+ */
+
+#ifndef UNIQUELIST_SET_KEY_H
+#define UNIQUELIST_SET_KEY_H
+
+#include <algorithm> // std::sort, std::unique
+#include <cstddef>
+#include <cstdint> // std::uint64_t
+#include <initializer_list>
+#include <memory>      // std::shared_ptr
+#include <type_traits> // std::remove_const_t
+#include <utility>     // std::pair
+#include <vector>
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Pairs of positions compared by the sorting network of size N
+ *
+ * These are the networks with the fewest comparators known for N <= 8.
+ */
+template <size_t N> struct sorting_network;
+
+template <> struct sorting_network<2> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {{0, 1}};
+};
+
+template <> struct sorting_network<3> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 2}, {0, 1}, {1, 2}};
+};
+
+template <> struct sorting_network<4> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 2}, {1, 3}, {0, 1}, {2, 3}, {1, 2}};
+};
+
+template <> struct sorting_network<5> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 3}, {1, 4}, {0, 2}, {1, 3}, {0, 1},
+      {2, 4}, {1, 2}, {3, 4}, {2, 3}};
+};
+
+template <> struct sorting_network<6> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 5}, {1, 3}, {2, 4}, {1, 2}, {3, 4}, {0, 3},
+      {2, 5}, {0, 1}, {2, 3}, {4, 5}, {1, 2}, {3, 4}};
+};
+
+template <> struct sorting_network<7> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 6}, {2, 3}, {4, 5}, {0, 2}, {1, 4}, {3, 6}, {0, 1}, {2, 5},
+      {3, 4}, {1, 2}, {4, 6}, {2, 3}, {4, 5}, {1, 2}, {3, 4}, {5, 6}};
+};
+
+template <> struct sorting_network<8> {
+  static constexpr std::pair<unsigned char, unsigned char> pairs[] = {
+      {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6},
+      {3, 7}, {0, 1}, {2, 3}, {4, 5}, {6, 7}, {2, 4}, {3, 5},
+      {1, 4}, {3, 6}, {1, 2}, {3, 4}, {5, 6}};
+};
+
+/**
+ * @brief Sort N elements by the sorting network
+ *
+ * Each comparator is a branchless min and max.
+ */
+template <size_t N, typename T> void network_sort(T *p) noexcept {
+  for (auto [i, j] : sorting_network<N>::pairs) {
+    T a = p[i];
+    T b = p[j];
+    p[i] = (b < a) ? b : a;
+    p[j] = (b < a) ? a : b;
+  }
+}
+
+/**
+ * @brief Mix the bits of an integer (the finaliser of splitmix64)
+ */
+constexpr std::uint64_t mix(std::uint64_t x) noexcept {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+} // namespace detail
+
+/**
+ * @brief Sort integers and remove duplicates in place
+ *
+ * Arrays of size up to 8 are sorted by sorting networks and longer
+ * ones by std::sort.
+ *
+ * @return Number of unique elements, which are moved to the front.
+ */
+template <typename T> size_t canonicalize(T *p, size_t n) {
+  switch (n) {
+  case 0:
+  case 1:
+    return n;
+  case 2:
+    detail::network_sort<2>(p);
+    break;
+  case 3:
+    detail::network_sort<3>(p);
+    break;
+  case 4:
+    detail::network_sort<4>(p);
+    break;
+  case 5:
+    detail::network_sort<5>(p);
+    break;
+  case 6:
+    detail::network_sort<6>(p);
+    break;
+  case 7:
+    detail::network_sort<7>(p);
+    break;
+  case 8:
+    detail::network_sort<8>(p);
+    break;
+  default:
+    std::sort(p, p + n);
+  }
+  return static_cast<size_t>(std::unique(p, p + n) - p);
+}
+
+/**
+ * @brief Hash a sorted array of integers
+ */
+template <typename T> std::uint64_t set_hash(const T *p, size_t n) noexcept {
+  std::uint64_t h = detail::mix(n);
+  for (size_t i = 0; i < n; ++i) {
+    h = detail::mix(h ^ static_cast<std::uint64_t>(p[i]));
+  }
+  return h;
+}
+
+/**
+ * @brief Set of integers in the canonical form
+ *
+ * This keeps a set of integers as a sorted array without duplicates,
+ * so that two sets are equal if and only if the arrays are equal.
+ * The hash of the array is computed once when the key is created.
+ *
+ * Two set_keys are compared by the sizes, the hashes and then the
+ * elements.  This order is not the lexicographic order of the sets
+ * but it is a total order, and most comparisons of distinct sets of
+ * the same size are resolved by the hashes without reading `ptr`.
+ */
+template <typename P> struct set_key {
+  using smart_pointer_type = P;
+
+  size_t size;
+  std::uint64_t hash;
+  P ptr;
+
+  template <typename Q>
+  friend bool operator<(const set_key<P> &l, const set_key<Q> &r) {
+    if (l.size != r.size) {
+      return l.size < r.size;
+    }
+    if (l.hash != r.hash) {
+      return l.hash < r.hash;
+    }
+    auto p = l.ptr.get();
+    auto q = r.ptr.get();
+    for (size_t i = 0; i < l.size; ++i) {
+      if (p[i] != q[i]) {
+        return p[i] < q[i];
+      }
+    }
+    return false;
+  }
+};
+
+/**
+ * @brief Compare two set_keys
+ *
+ * This is called by `strictly_less`.  Integers are compared exactly.
+ */
+template <typename P, typename Q>
+bool tolerant_less(const strictly_less &less, const set_key<P> &a,
+                   const set_key<Q> &b) {
+  (void)less;
+  return a < b;
+}
+
+/**
+ * @brief Create a set_key of a canonical array without copying it
+ *
+ * `p` must be sorted and have no duplicates, for example by
+ * `canonicalize`.
+ */
+template <typename P> auto as_set_key(size_t size, P p) {
+  auto hash = set_hash(p.get(), size);
+  return set_key<P>{size, hash, std::move(p)};
+}
+
+/**
+ * @brief Deepcopy a set_key
+ */
+template <typename P> auto deepcopy(const set_key<P> &p) {
+  auto copy = deepcopy(sized_ptr<P>{p.size, p.ptr});
+  return set_key<P>{p.size, p.hash, std::move(copy.ptr)};
+}
+
+/**
+ * @brief Allocate a memory block and create a set_key
+ *
+ * This copies the integers passed in the initializer list and
+ * canonicalizes them.
+ */
+template <typename T> auto as_set_key(std::initializer_list<T> &&l) {
+  std::vector<T> buf(l);
+  auto n = canonicalize(buf.data(), buf.size());
+  std::shared_ptr<T[]> p{new T[n]};
+  std::copy(buf.begin(), buf.begin() + static_cast<long>(n), p.get());
+  return as_set_key(n, std::move(p));
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_SET_KEY_H
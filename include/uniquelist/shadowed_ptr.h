@@ -0,0 +1,198 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Sized ptr with a single precision copy of its elements
+ */
+
+#ifndef UNIQUELIST_SHADOWED_PTR_H
+#define UNIQUELIST_SHADOWED_PTR_H
+
+#include <cmath>       // std::abs, std::isfinite
+#include <cstddef>
+#include <limits>      // std::numeric_limits
+#include <memory>      // std::shared_ptr
+#include <type_traits> // std::remove_const_t
+#include <utility>     // std::move
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Sized ptr with a single precision copy of its elements
+ *
+ * This is a sized_ptr of doubles which additionally keeps a copy of
+ * the elements rounded to float, called the shadow.  `strictly_less`
+ * first compares the shadows, which are half the size of the original
+ * elements, and reads the original elements only if the shadows are
+ * too close to the boundary of the tolerance to decide the order.
+ *
+ * The shadow may be null, for example in a key which is only searched
+ * for.  Then the original elements of that key are used.
+ */
+template <typename P> struct shadowed_ptr : sized_ptr<P> {
+  std::shared_ptr<const float[]> shadow{};
+
+  template <typename Q>
+  friend bool operator<(const shadowed_ptr<P> &l, const shadowed_ptr<Q> &r) {
+    return static_cast<const sized_ptr<P> &>(l) <
+           static_cast<const sized_ptr<Q> &>(r);
+  }
+};
+
+/**
+ * @brief Round an array to float
+ *
+ * Elements which are not finite as floats, such as those too large
+ * for float, are replaced with NaN, so that they are never decided by
+ * the shadow.
+ */
+template <typename T>
+std::shared_ptr<const float[]> make_shadow(const T *p, size_t n) {
+  std::shared_ptr<float[]> out{new float[n]};
+  for (size_t i = 0; i < n; ++i) {
+    auto x = static_cast<float>(p[i]);
+    out[i] = std::isfinite(x) ? x : std::numeric_limits<float>::quiet_NaN();
+  }
+  return out;
+}
+
+/**
+ * @brief Create a shadowed_ptr from a sized_ptr
+ *
+ * This allocates the shadow.  The memory block pointed by `p` is
+ * shared, not copied.
+ */
+template <typename P> auto with_shadow(sized_ptr<P> p) {
+  shadowed_ptr<P> out{};
+  out.shadow = make_shadow(p.ptr.get(), p.size);
+  static_cast<sized_ptr<P> &>(out) = std::move(p);
+  return out;
+}
+
+/**
+ * @brief Create a shadowed_ptr without a shadow
+ *
+ * This may be used to search for an array without allocating a shadow.
+ */
+template <typename P> auto without_shadow(sized_ptr<P> p) {
+  shadowed_ptr<P> out{};
+  static_cast<sized_ptr<P> &>(out) = std::move(p);
+  return out;
+}
+
+/**
+ * @brief Deepcopy a shadowed_ptr
+ *
+ * This deepcopies the memory block and shares the shadow, which is
+ * created if it is null.
+ */
+template <typename P> auto deepcopy(const shadowed_ptr<P> &p) {
+  auto out = p;
+  static_cast<sized_ptr<P> &>(out) =
+      deepcopy(static_cast<const sized_ptr<P> &>(p));
+  if (!out.shadow) {
+    out.shadow = make_shadow(out.ptr.get(), out.size);
+  }
+  return out;
+}
+
+namespace detail {
+
+/**
+ * @brief Elements of an array read from the shadow if available
+ */
+template <typename T> struct shadow_reader {
+  const T *full;
+  const float *shadow;
+
+  /**
+   * @brief Return an element and a bound of its rounding error
+   *
+   * A float is within 2^-24 of the original double relative to the
+   * float, or 2^-150 if subnormal.  The bound is doubled to cover the
+   * rounding in the comparison.  It is NaN if the shadow is NaN, so
+   * that no decision is made from it.
+   */
+  void get(size_t i, double &value, double &error) const noexcept {
+    if (shadow) {
+      value = shadow[i];
+      error = std::abs(value) * 0x1p-23 + 0x1p-149;
+    } else {
+      value = static_cast<double>(full[i]);
+      error = 0;
+    }
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief Compare two shadowed_ptrs with a tolerance
+ *
+ * This is called by `strictly_less` and gives the same result as
+ * `strictly_less` applied to the original elements.  Each pair of
+ * elements is decided by the shadows if the order holds for any
+ * values within the rounding errors.  Otherwise the original elements
+ * are read.
+ *
+ * If both keys have shadows, `rtol` is at least 2^-21 and `atol` is
+ * at least 2^-148, elements whose shadows are equal are equal within
+ * the tolerance.  Then such elements are skipped by comparing the
+ * shadows only.  `atol` must cover the rounding of tiny numbers, such
+ * as 0 and 1e-46, to the same float.
+ */
+template <typename P, typename Q>
+bool tolerant_less(const strictly_less &less, const shadowed_ptr<P> &a,
+                   const shadowed_ptr<Q> &b) {
+  if (a.size != b.size) {
+    return a.size < b.size;
+  }
+  auto p = a.ptr.get();
+  auto q = b.ptr.get();
+  detail::shadow_reader<std::remove_const_t<std::remove_extent_t<
+      typename P::element_type>>>
+      s{p, a.shadow.get()};
+  detail::shadow_reader<std::remove_const_t<std::remove_extent_t<
+      typename Q::element_type>>>
+      t{q, b.shadow.get()};
+  // `bound(y)` is the threshold of `strictly_less`, increasing in y.
+  auto bound = [&](double y) {
+    return y - std::abs(y) * less.rtol - less.atol;
+  };
+  auto skip =
+      s.shadow && t.shadow && less.rtol >= 0x1p-21 && less.atol >= 0x1p-148;
+  for (size_t i = 0; i < a.size; ++i) {
+    if (skip) {
+      while (i < a.size && s.shadow[i] == t.shadow[i]) {
+        ++i;
+      }
+      if (i == a.size) {
+        break;
+      }
+    }
+    double x, ex, y, ey;
+    s.get(i, x, ex);
+    t.get(i, y, ey);
+    if (x - ex >= bound(y + ey) && y - ey >= bound(x + ex)) {
+      continue; // Equal within the tolerance.
+    } else if (x + ex < bound(y - ey)) {
+      return true;
+    } else if (y + ey < bound(x - ex)) {
+      return false;
+    }
+    // The shadows are close to the boundary of the tolerance.
+    if (less(p[i], q[i])) {
+      return true;
+    } else if (less(q[i], p[i])) {
+      return false;
+    }
+  }
+  return false;
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_SHADOWED_PTR_H
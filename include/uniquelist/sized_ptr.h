@@ -9,6 +9,7 @@
 #ifndef UNIQUELIST_SIZED_PTR_H
 #define UNIQUELIST_SIZED_PTR_H
 
+#include <algorithm> // std::copy
 #include <concepts>
 #include <cstddef>
 #include <cstring>
@@ -20,6 +21,12 @@
 
 namespace uniquelist {
 
+template <typename T> struct view_ptr;
+
+template <typename P> struct is_view_ptr : std::false_type {};
+
+template <typename T> struct is_view_ptr<view_ptr<T>> : std::true_type {};
+
 /**
  * @brief Shared ptr with size
  *
@@ -79,6 +86,63 @@ template <typename P> struct sized_ptr {
  * does not shared a memory block.
  */
 template <typename P> auto deepcopy(const sized_ptr<P> &p) {
+  static_assert(!is_view_ptr<P>::value,
+                "a view cannot own a copy; use copy_as instead");
+  using nonconst_element_type =
+      std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
+  std::unique_ptr<nonconst_element_type[]> out_p{
+      new nonconst_element_type[p.size]};
+  std::copy(p.ptr.get(), p.ptr.get() + p.size, out_p.get());
+  return sized_ptr<P>{p.size, P{out_p.release()}};
+}
+
+/**
+ * @brief Non-owning pointer to an array
+ *
+ * This provides the interface of a smart pointer used by sized_ptr,
+ * but it neither owns the array nor counts references.  A sized_ptr
+ * of view_ptr can be used to search for a key without allocating
+ * memory or touching reference counts, for example by `isin` or
+ * `push_back_with_hook`.
+ */
+template <typename T> struct view_ptr {
+  using element_type = std::remove_extent_t<T>;
+
+  element_type *p = nullptr;
+
+  constexpr view_ptr() noexcept = default;
+
+  constexpr view_ptr(element_type *p) noexcept : p{p} {}
+
+  constexpr element_type *get() const noexcept { return p; }
+
+  constexpr element_type &operator[](size_t i) const noexcept { return p[i]; }
+
+  constexpr explicit operator bool() const noexcept { return p != nullptr; }
+};
+
+/**
+ * @brief Create a sized_ptr of view_ptr from a pointer
+ */
+template <typename T> auto as_view(size_t size, T *p) {
+  return sized_ptr<view_ptr<T[]>>{size, view_ptr<T[]>{p}};
+}
+
+/**
+ * @brief Copy a sized_ptr to a memory block owned by a given pointer type
+ *
+ * This allocates a memory block, copies the elements of `p` and
+ * returns a sized_ptr<P>.  P may be std::unique_ptr, so that the
+ * result is moved into a list without touching reference counts.
+ *
+ * ```
+ * using key = sized_ptr<std::unique_ptr<double[]>>;
+ * list.push_back_with_hook(as_view(n, p), [](const auto &x) {
+ *   return copy_as<std::unique_ptr<double[]>>(x);
+ * });
+ * ```
+ */
+template <typename P, typename Q> auto copy_as(const sized_ptr<Q> &p) {
   using nonconst_element_type =
       std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
   std::unique_ptr<nonconst_element_type[]> out_p{
@@ -89,19 +153,44 @@ template <typename P> auto deepcopy(const sized_ptr<P> &p) {
 
 /**
  * @brief Compare two numbers with a tolerance
+ *
+ * This is a transparent comparator, so that a map using this can be
+ * searched by a key of another type such as a sized_ptr of view_ptr.
  */
 struct strictly_less {
+  using is_transparent = void;
+
   double rtol;
   double atol;
 
-  strictly_less(double rtol = 1e-6, double atol = 1e-6)
+  constexpr strictly_less(double rtol = 1e-6, double atol = 1e-6)
       : rtol{rtol}, atol{atol} {}
 
+  /**
+   * @brief Return the comparison object with the tolerance times f
+   */
+  constexpr strictly_less widened(double f) const {
+    return strictly_less{rtol * f, atol * f};
+  }
+
   template <typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
-  bool operator()(T a, T b) const {
+  constexpr bool operator()(T a, T b) const {
     return a < b - ((b > 0) ? b : -b) * this->rtol - this->atol;
   }
 
+  /**
+   * @brief Compare two keys of a type defined in another header
+   *
+   * This calls `tolerant_less(*this, a, b)`, which is looked up
+   * by argument-dependent lookup.  Key types such as fixed_array
+   * define the function next to the type.
+   */
+  template <typename S, typename T,
+            std::enable_if_t<!std::is_arithmetic<S>::value, int> = 0>
+  constexpr bool operator()(const S &a, const T &b) const {
+    return tolerant_less(*this, a, b);
+  }
+
   template <typename S, typename T>
   bool operator()(const sized_ptr<S> &a, const sized_ptr<T> &b) const {
     if (a.size < b.size) {
@@ -123,6 +212,33 @@ struct strictly_less {
   }
 };
 
+/**
+ * @brief Statistics of the depth of comparisons of arrays
+ *
+ * `comparisons` is the number of comparisons made and `scanned` is
+ * the number of elements read in them.  Comparators such as lcp_less
+ * record them if they are given a shared pointer to this.
+ */
+struct depth_stats {
+  size_t comparisons = 0;
+  size_t scanned = 0;
+
+  /**
+   * @brief Return the average number of elements read per comparison
+   */
+  double depth() const noexcept {
+    return comparisons > 0 ? static_cast<double>(scanned) / comparisons : 0.0;
+  }
+
+  /**
+   * @brief Reset the counters
+   */
+  void reset() noexcept {
+    comparisons = 0;
+    scanned = 0;
+  }
+};
+
 /**
  * @brief Allocate a memory and initialise by sequence of numbers
  *
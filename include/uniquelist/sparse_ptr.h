@@ -0,0 +1,189 @@
+/**
+ * @file
+ * @author Nagisa Sugishita <s1576972@ed.ac.uk>
+ * @version 1.0
+ *
+ * Sparse array with shared ptrs
+ */
+
+#ifndef UNIQUELIST_SPARSE_PTR_H
+#define UNIQUELIST_SPARSE_PTR_H
+
+#include <algorithm> // std::copy
+#include <cstddef>
+#include <functional>       // std::less
+#include <initializer_list> // std::initializer_list
+#include <iterator>         // std::data
+#include <memory>           // std::shared_ptr, std::unique_ptr
+#include <stdexcept>        // std::invalid_argument
+#include <type_traits>      // std::remove_const_t, std::is_signed
+
+#include "uniquelist/sized_ptr.h"
+
+namespace uniquelist {
+
+/**
+ * @brief Sparse array with shared ptrs
+ *
+ * This keeps the nonzero elements of an array of size `size`.
+ * `index` points to `nnz` indexes of the nonzero elements in the
+ * increasing order and `value` points to their values.
+ *
+ * Two sparse_ptrs are compared as if they were dense arrays:
+ * by the sizes first and then lexicographically.  The comparison
+ * merges the two index arrays, so that it only reads the nonzero
+ * elements.  An element which is explicitly stored as zero is
+ * equal to one which is not stored.
+ */
+template <typename P, typename Q> struct sparse_ptr {
+  using smart_pointer_type = P;
+  using index_pointer_type = Q;
+
+  size_t size;
+  size_t nnz;
+  Q index;
+  P value;
+
+  /**
+   * @brief Compare two sparse_ptr instances as dense arrays
+   */
+  template <typename R, typename S>
+  friend bool operator<(const sparse_ptr<P, Q> &l, const sparse_ptr<R, S> &r) {
+    using element_type = std::remove_const_t<
+        std::remove_extent_t<typename P::element_type>>;
+    return sparse_less(std::less<element_type>{}, l, r);
+  }
+};
+
+/**
+ * @brief Compare two sparse arrays as dense arrays
+ *
+ * This compares the sizes of the arrays first.  If they are the
+ * same, the elements are compared one by one using `less` as in
+ * the dense arrays, while only the indexes where either of the arrays
+ * has a nonzero element are visited.
+ */
+template <typename L, typename P, typename Q, typename R, typename S>
+bool sparse_less(const L &less, const sparse_ptr<P, Q> &a,
+                 const sparse_ptr<R, S> &b) {
+  if (a.size != b.size) {
+    return a.size < b.size;
+  }
+  using element_type =
+      std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
+  auto ai = a.index.get();
+  auto av = a.value.get();
+  auto bi = b.index.get();
+  auto bv = b.value.get();
+  auto aend = ai + a.nnz;
+  auto bend = bi + b.nnz;
+  while (ai != aend || bi != bend) {
+    element_type x = 0;
+    element_type y = 0;
+    if (bi == bend || (ai != aend && *ai < *bi)) {
+      x = *av++;
+      ++ai;
+    } else if (ai == aend || *bi < *ai) {
+      y = *bv++;
+      ++bi;
+    } else {
+      x = *av++;
+      ++ai;
+      y = *bv++;
+      ++bi;
+    }
+    if (less(x, y)) {
+      return true;
+    } else if (less(y, x)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Compare two sparse arrays with a tolerance
+ *
+ * This is called by `strictly_less`.
+ */
+template <typename P, typename Q, typename R, typename S>
+bool tolerant_less(const strictly_less &less, const sparse_ptr<P, Q> &a,
+                   const sparse_ptr<R, S> &b) {
+  return sparse_less(less, a, b);
+}
+
+/**
+ * @brief Deepcopy a sparse_ptr
+ *
+ * This deepcopies a sparse_ptr instance.  Elements explicitly stored
+ * as zeros are dropped in the copy.
+ */
+template <typename P, typename Q> auto deepcopy(const sparse_ptr<P, Q> &p) {
+  using value_type =
+      std::remove_const_t<std::remove_extent_t<typename P::element_type>>;
+  using index_type =
+      std::remove_const_t<std::remove_extent_t<typename Q::element_type>>;
+  size_t nnz = 0;
+  for (size_t i = 0; i < p.nnz; ++i) {
+    nnz += (p.value[i] != 0);
+  }
+  std::unique_ptr<index_type[]> index{new index_type[nnz]};
+  std::unique_ptr<value_type[]> value{new value_type[nnz]};
+  for (size_t i = 0, j = 0; i < p.nnz; ++i) {
+    if (p.value[i] != 0) {
+      index[j] = p.index[i];
+      value[j] = p.value[i];
+      ++j;
+    }
+  }
+  return sparse_ptr<P, Q>{p.size, nnz, Q{index.release()}, P{value.release()}};
+}
+
+/**
+ * @brief Test if indexes of a sparse array are valid
+ *
+ * This checks that the indexes are in the strictly increasing order
+ * and they are smaller than the size.
+ */
+template <typename T>
+bool is_valid_sparse_index(size_t size, size_t nnz, const T *index) {
+  for (size_t i = 0; i < nnz; ++i) {
+    if constexpr (std::is_signed<T>::value) {
+      if (index[i] < 0) {
+        return false;
+      }
+    }
+    if (static_cast<size_t>(index[i]) >= size) {
+      return false;
+    }
+    if (i > 0 && !(index[i - 1] < index[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Allocate memory blocks and create a sparse pointer
+ *
+ * This allocates memory blocks and copies the indexes and the values
+ * passed in the initializer lists.  The indexes must be in the
+ * increasing order.
+ */
+template <typename I, typename T>
+auto as_sparse_ptr(size_t size, std::initializer_list<I> &&index,
+                   std::initializer_list<T> &&value) {
+  if (index.size() != value.size()) {
+    throw std::invalid_argument("index and value must have the same size");
+  }
+  if (!is_valid_sparse_index(size, index.size(), std::data(index))) {
+    throw std::invalid_argument("invalid sparse index");
+  }
+  return sparse_ptr<std::shared_ptr<T[]>, std::shared_ptr<I[]>>{
+      size, index.size(), as_shared_ptr(std::move(index)),
+      as_shared_ptr(std::move(value))};
+}
+
+} // namespace uniquelist
+
+#endif // UNIQUELIST_SPARSE_PTR_H
@@ -11,11 +11,140 @@
 #ifndef UNIQUELIST_UNIQUELIST_H
 #define UNIQUELIST_UNIQUELIST_H
 
+#include <algorithm>   // std::stable_sort
+#include <functional>  // std::less, std::greater
+#include <iterator>    // std::prev
 #include <list>        // std::list
 #include <map>         // std::map
 #include <memory>      // std::shared_ptr
-#include <type_traits> // std::is_same
+#include <numeric>     // std::iota
+#include <stdexcept>   // std::out_of_range
+#include <type_traits> // std::is_same, std::void_t
 #include <utility>     // std::pair
+#include <vector>      // std::vector
+
+namespace uniquelist {
+
+namespace detail {
+
+/**
+ * @brief Test if a map can find the upper bound of a key of type K
+ */
+template <typename Map, typename K, typename = void>
+struct has_upper_bound : std::false_type {};
+
+template <typename Map, typename K>
+struct has_upper_bound<Map, K,
+                       std::void_t<decltype(std::declval<Map &>().upper_bound(
+                           std::declval<const K &>()))>> : std::true_type {};
+
+/**
+ * @brief Test if a map can extract a node as std::map does
+ */
+template <typename Map, typename = void>
+struct has_extract : std::false_type {};
+
+template <typename Map>
+struct has_extract<Map, std::void_t<decltype(std::declval<Map &>().extract(
+                            std::declval<typename Map::iterator>()))>>
+    : std::true_type {};
+
+/**
+ * @brief Test if a comparison object compares keys without a tolerance
+ *
+ * This is true for std::less, std::greater and a comparison object
+ * which defines `is_exact`, in the same way as `is_transparent`.
+ */
+template <typename Compare, typename = void>
+struct is_exact : std::false_type {};
+
+template <typename T> struct is_exact<std::less<T>> : std::true_type {};
+
+template <typename T> struct is_exact<std::greater<T>> : std::true_type {};
+
+template <typename Compare>
+struct is_exact<Compare, std::void_t<typename Compare::is_exact>>
+    : std::true_type {};
+
+/**
+ * @brief Test if a comparison object can widen its tolerance
+ *
+ * `comp.widened(f)` returns the same comparison object but with the
+ * tolerance multiplied by f.
+ */
+template <typename Compare, typename = void>
+struct has_widened : std::false_type {};
+
+template <typename Compare>
+struct has_widened<Compare, std::void_t<decltype(std::declval<const Compare &>()
+                                                     .widened(2.0))>>
+    : std::true_type {};
+
+/**
+ * @brief Fenwick tree of flags
+ *
+ * This counts the flags set before a slot, and finds the slot of the
+ * k-th flag set, in O(log n) time.  `tree[k - 1]` is the number of
+ * the flags set in the slots (k - lowbit(k), k] counted from 1.
+ */
+struct fenwick_tree {
+  std::vector<size_t> tree{};
+
+  static size_t lowbit(size_t k) noexcept { return k & (~k + 1); }
+
+  /** Set n flags. */
+  void assign(size_t n) {
+    tree.resize(n);
+    for (size_t k = 1; k <= n; ++k) {
+      tree[k - 1] = lowbit(k);
+    }
+  }
+
+  /** Add a slot with its flag set at the end. */
+  void push_back() {
+    auto k = tree.size() + 1;
+    tree.push_back(1 + count(k - 1) - count(k - lowbit(k)));
+  }
+
+  /** Remove the last slot. */
+  void pop_back() { tree.pop_back(); }
+
+  /** Reset the flag of slot i, which must be set. */
+  void reset(size_t i) noexcept {
+    for (auto k = i + 1; k <= tree.size(); k += lowbit(k)) {
+      --tree[k - 1];
+    }
+  }
+
+  /** Return the number of the flags set in the slots before i. */
+  size_t count(size_t i) const noexcept {
+    size_t out = 0;
+    for (auto k = i; k > 0; k -= lowbit(k)) {
+      out += tree[k - 1];
+    }
+    return out;
+  }
+
+  /** Return the slot of the flag set after r flags set. */
+  size_t find(size_t r) const noexcept {
+    size_t step = 1;
+    while (step * 2 <= tree.size()) {
+      step *= 2;
+    }
+    size_t k = 0;
+    for (; step > 0; step /= 2) {
+      if (k + step <= tree.size() && tree[k + step - 1] <= r) {
+        k += step;
+        r -= tree[k - 1];
+      }
+    }
+    return k;
+  }
+};
+
+} // namespace detail
+
+} // namespace uniquelist
 
 namespace uniquelist {
 
@@ -62,8 +191,18 @@ namespace uniquelist {
  * When one wants to check if an item is already added or not,
  * one can check the item is in the map as a key or not.
  *
+ * By default the map is std::map.  Another container with the same
+ * interface can be given as `Map`, such as grid_map which finds
+ * the arrays equal within a tolerance by hashing.  `Map<T, V, Compare>`
+ * must provide `insert`, `try_emplace`, `emplace_hint`, `find`, `count`,
+ * `erase`, `begin`, `end`, `size`, `max_size`, `clear` and `key_comp`
+ * as std::map does and its iterators must remain valid until the
+ * element is erased.
+ *
  */
-template <typename T, typename Compare = std::less<T>> struct uniquelist {
+template <typename T, typename Compare = std::less<T>,
+          template <typename...> class Map = std::map>
+struct uniquelist {
 
 protected:
   struct map_item_type;
@@ -77,7 +216,13 @@ protected:
    * to the original element in the list.
    */
   struct list_item_type {
-    typename std::map<T, map_item_type, Compare>::iterator link;
+    typename Map<T, map_item_type, Compare>::iterator link;
+
+    /**
+     * Slot in `items`, which is valid if `indexed` is true.  The slots
+     * increase along the list and those of erased items are skipped.
+     */
+    size_t index = 0;
   };
 
   /**
@@ -100,7 +245,7 @@ protected:
   /**
    * @brief Type of the underlying map
    */
-  using map_type = std::map<T, map_item_type, Compare>;
+  using map_type = Map<T, map_item_type, Compare>;
 
   /**
    * @brief Iterator to iterate elements in the order they are added
@@ -218,6 +363,38 @@ public:
 
   /* Member functions */
 
+  /**
+   * @brief Construct an empty list
+   */
+  uniquelist() = default;
+
+  /**
+   * @brief Construct an empty list with a given comparison object
+   *
+   * @param [in] comp Comparison object used to sort the elements.
+   * @param [in] args Additional arguments passed to the constructor
+   *     of the underlying map.
+   */
+  template <typename... Args>
+  explicit uniquelist(const Compare &comp, Args &&...args)
+      : map(comp, std::forward<Args>(args)...) {}
+
+  /* Observers */
+
+  /**
+   * @brief Return the comparison object
+   *
+   * @return Copy of the comparison object used to sort the elements.
+   */
+  auto key_comp() const { return map.key_comp(); }
+
+  /**
+   * @brief Return the underlying map
+   *
+   * This gives access to the parameters of a map such as grid_map.
+   */
+  const map_type &get_map() const noexcept { return map; }
+
   /* Iterators */
 
   /**
@@ -260,9 +437,7 @@ public:
    *
    * @return An iterator to the beginning of the sequence container.
    */
-  auto sbegin() const noexcept {
-    return const_map_iterator_wrapper(std::begin(map));
-  }
+  auto sbegin() const noexcept { return const_map_iterator(std::begin(map)); }
 
   /**
    * @brief Returns an iterator referring to the past-the-end element
@@ -276,9 +451,7 @@ public:
    *
    * @return An iterator to the element past the end of the sequence.
    */
-  auto send() const noexcept {
-    return const_map_iterator_wrapper(std::end(map));
-  }
+  auto send() const noexcept { return const_map_iterator(std::end(map)); }
 
   /* Capacity */
 
@@ -348,6 +521,18 @@ public:
     return insert_with_hook(std::end(*this), key, f);
   }
 
+  /**
+   * @brief Add a new item to the end if it is not in the list
+   *
+   * This is the same as above but the value may be of another type
+   * than T, such as a sized_ptr of view_ptr, if the comparison object
+   * can compare it with T.  The hook must return T.
+   */
+  template <typename K, typename F>
+  auto push_back_with_hook(const K &key, const F &f) {
+    return insert_with_hook(std::end(*this), key, f);
+  }
+
   /**
    * @brief Insert a new element before the the specified position
    *
@@ -362,16 +547,14 @@ public:
    */
   template <typename S>
   auto insert(iterator_wrapper<S> position, const value_type &val) {
-    // auto [it, status] = map.insert(std::pair(val, map_item_type{}));
-    auto buf = map.insert(std::pair<T, map_item_type>(val, map_item_type{}));
+    // auto [it, status] = map.try_emplace(val, map_item_type{});
+    auto buf = map.try_emplace(val, map_item_type{});
     auto it = std::get<0>(buf);
     auto status = std::get<1>(buf);
     if (status) {
-      it->second.link =
-          list.insert(position.get_list_iterator(), list_item_type{it});
+      it->second.link = link(position.get_list_iterator(), it);
     }
-    return std::pair<size_t, bool>(
-        std::distance(std::begin(list), it->second.link), status);
+    return std::pair<size_t, bool>(position_of(it->second.link), status);
   }
 
   /**
@@ -393,11 +576,9 @@ public:
     auto it = std::get<0>(buf);
     auto status = std::get<1>(buf);
     if (status) {
-      it->second.link =
-          list.insert(position.get_list_iterator(), list_item_type{it});
+      it->second.link = link(position.get_list_iterator(), it);
     }
-    return std::pair<size_t, bool>(
-        std::distance(std::begin(list), it->second.link), status);
+    return std::pair<size_t, bool>(position_of(it->second.link), status);
   }
 
   /**
@@ -405,39 +586,29 @@ public:
    *
    * @param [in] Position in the container where
    *     the new elements are inserted.
-   * @param [in] Value to be added
+   * @param [in] Value to be added.  This may be of another type than
+   *     T, such as a sized_ptr of view_ptr, if the comparison object
+   *     can compare it with T.  It is neither copied nor stored.
    * @param [in] Hook called when the value is added. This may be
    *     useful when we want to deepcopy the value only if
-   *     the item is new.
+   *     the item is new.  The returned value is moved into the map.
    *
    * @return Pair of the position of the given item in the list
    *     and status.  status = true indicates that the item is added
    *     as a new one and false indicates that the item is already
    *     in the list.
    */
-  template <typename S, typename F>
-  auto insert_with_hook(iterator_wrapper<S> position, const value_type &val,
+  template <typename S, typename K, typename F>
+  auto insert_with_hook(iterator_wrapper<S> position, const K &val,
                         const F &f) {
-    // First, add the item without calling the hook.
-    // auto [it, status] = map.insert(std::pair(val, map_item_type{}));
-    auto buf = map.insert(std::pair<T, map_item_type>(val, map_item_type{}));
-    auto it = std::get<0>(buf);
-    auto status = std::get<1>(buf);
-    if (status) { // If the given item is new.
-      // Remove the item added above and add the one returned by the hook.
-      auto hint = it; // Pos just before the newly added element.
-      ++hint;
-      map.erase(it); // Remove the item added above.
-      // Call the hook and re-insert the result to the map.
-      auto new_it = map.emplace_hint(hint, f(val), map_item_type{});
-      new_it->second.link =
-          list.insert(position.get_list_iterator(), list_item_type{new_it});
-      return std::pair<size_t, bool>(
-          std::distance(std::begin(list), new_it->second.link), status);
-    } else { // If the given item is not new.
-      return std::pair<size_t, bool>(
-          std::distance(std::begin(list), it->second.link), status);
+    auto [it, found] = find_or_hint(val);
+    if (found) { // If the given item is not new.
+      return std::pair<size_t, bool>(position_of(it->second.link), false);
     }
+    // Call the hook and insert the result to the map.
+    auto new_it = map.emplace_hint(it, f(val), map_item_type{});
+    new_it->second.link = link(position.get_list_iterator(), new_it);
+    return std::pair<size_t, bool>(position_of(new_it->second.link), true);
   }
 
   /**
@@ -453,9 +624,9 @@ public:
   template <typename S> auto erase(iterator_wrapper<S> it) {
     if constexpr (iterator_wrapper<S>::is_list_iterator) {
       map.erase(it.get_map_iterator());
-      return iterator_wrapper<S>(list.erase(it.get_list_iterator()));
+      return iterator_wrapper<S>(unlink(it.get_list_iterator()));
     } else {
-      list.erase(it.get_list_iterator());
+      unlink(it.get_list_iterator());
       return iterator_wrapper<S>(map.erase(it.get_map_iterator()));
     }
   }
@@ -471,9 +642,8 @@ public:
    *     the element erased by the function call.
    */
   auto erase(size_t index) {
-    auto it = std::begin(*this);
-    std::advance(it, index);
-    return erase(it);
+    reindex();
+    return erase(list_iterator_wrapper(items[slot_at(index)]));
   }
 
   /**
@@ -524,8 +694,193 @@ public:
   auto clear() noexcept {
     list.clear();
     map.clear();
+    items.clear();
+    alive.tree.clear();
+    indexed = true;
+  }
+
+  /**
+   * @brief Replace the elements with elements in the order of the map
+   *
+   * The elements are inserted at the end of the map with a hint, so
+   * that this takes linear time for a sorted map if the elements are
+   * in its order, such as those saved from `sbegin()` to `send()` of
+   * a list with the same comparison object.  As in `rebuild`, an
+   * element equal to an earlier one is removed, which happens to
+   * a list saved when `strictly_sorted()` is false.  The elements are
+   * inserted by `try_emplace` into a map which is not sorted, since
+   * such a map may take the hint `end()` to mean that the element is
+   * not in it.
+   *
+   * @param [in] n Number of elements.
+   * @param [in] key Function which returns the i-th element given i.
+   * @param [in] positions Position in the list of each element, which
+   *     is a permutation of 0, 1, ..., n - 1.  size: n
+   *
+   * @return Number of the elements removed.
+   *
+   * @throw std::invalid_argument if positions is not a permutation.
+   */
+  template <typename F, typename U>
+  size_t assign_sorted(size_t n, const F &key, const U *positions) {
+    std::vector<bool> seen(n, false);
+    for (size_t i = 0; i < n; ++i) {
+      auto p = static_cast<size_t>(positions[i]);
+      if (p >= n || seen[p]) { // Negative positions wrap around.
+        throw std::invalid_argument("positions must be a permutation");
+      }
+      seen[p] = true;
+    }
+    clear();
+    std::vector<typename map_type::iterator> at(n, std::end(map));
+    for (size_t i = 0; i < n; ++i) {
+      auto size = map.size();
+      typename map_type::iterator it;
+      if constexpr (detail::has_upper_bound<map_type, T>::value) {
+        it = map.emplace_hint(std::end(map), key(i), map_item_type{});
+      } else {
+        it = map.try_emplace(key(i), map_item_type{}).first;
+      }
+      if (map.size() > size) {
+        at[static_cast<size_t>(positions[i])] = it;
+      }
+    }
+    for (auto it : at) {
+      if (it != std::end(map)) {
+        it->second.link = link(std::end(list), it);
+      }
+    }
+    return n - map.size();
+  }
+
+  /**
+   * @brief Return the positions of the elements in the order of the map
+   */
+  std::vector<size_t> sorted_positions() {
+    std::vector<size_t> out;
+    out.reserve(list.size());
+    for (const auto &x : map) {
+      out.push_back(position_of(x.second.link));
+    }
+    return out;
+  }
+
+  /**
+   * @brief Test if each element in the map is less than the next one
+   *
+   * Under a comparison with a tolerance, erasing an element may leave
+   * two neighbouring elements in the map equal to each other.  No map
+   * accepts both of them again, so that such a list cannot be restored
+   * by `assign_sorted`.  A map which is not sorted is always true.
+   */
+  bool strictly_sorted() const {
+    if constexpr (detail::has_upper_bound<map_type, T>::value) {
+      auto comp = map.key_comp();
+      auto it = std::begin(map);
+      if (it == std::end(map)) {
+        return true;
+      }
+      for (auto prev = it++; it != std::end(map); prev = it++) {
+        if (!comp(prev->first, it->first)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Rebuild the map with a new comparison object
+   *
+   * The elements are inserted to a new map in the order of addition.
+   * The keys are moved if the map supports `extract` and copied
+   * otherwise.  Since the equality under a tolerance is not
+   * transitive, an element may be found equal to an earlier one under
+   * the new comparison.  Such elements are removed from the list.
+   *
+   * @param [in] comp New comparison object.
+   *
+   * @return Number of the elements removed.
+   */
+  size_t rebuild(const Compare &comp) {
+    map_type other(comp);
+    size_t removed = 0;
+    for (auto it = std::begin(list); it != std::end(list);) {
+      bool inserted;
+      if constexpr (detail::has_extract<map_type>::value) {
+        auto node = map.extract(it->link);
+        auto result = other.insert(std::move(node));
+        inserted = result.inserted;
+        it->link = result.position;
+      } else {
+        auto result = other.try_emplace(it->link->first, it->link->second);
+        inserted = result.second;
+        it->link = result.first;
+      }
+      if (inserted) {
+        ++it;
+      } else {
+        it = unlink(it);
+        ++removed;
+      }
+    }
+    map.swap(other);
+    return removed;
   }
 
+  /**
+   * @brief Return the element at a given position
+   *
+   * This takes constant time if no item has been removed from the
+   * middle of the list and O(log n) time otherwise.  After an item is
+   * inserted in the middle of the list, the positions are renumbered
+   * in O(n) time once.
+   *
+   * @param [in] position Position in the list.
+   *
+   * @throw std::out_of_range if position is not smaller than size().
+   */
+  const T &at(size_t position) {
+    reindex();
+    return std::as_const(*this).at(position);
+  }
+
+  /**
+   * @brief Return the element at a given position without renumbering
+   *
+   * This is the same as above but does not modify the list, so that it
+   * may be called by several threads at the same time.  The positions
+   * must be numbered.
+   *
+   * @throw std::out_of_range if position is not smaller than size().
+   * @throw std::logic_error if `numbered()` is false.
+   */
+  const T &at(size_t position) const {
+    check_numbered();
+    if (position >= list.size()) {
+      throw std::out_of_range("position out of range");
+    }
+    return items[slot_at(position)]->link->first;
+  }
+
+  /**
+   * @brief Test if the positions can be found without renumbering
+   *
+   * This is false after many items are erased, until a position is
+   * searched for by a non-const method.  Then `renumber` must be
+   * called before the const versions of `at`, `index` and
+   * `index_many`.
+   */
+  bool numbered() const noexcept { return indexed; }
+
+  /**
+   * @brief Renumber the positions if they are invalid
+   *
+   * This takes O(n) time if `numbered()` is false and constant time
+   * otherwise.
+   */
+  void renumber() { reindex(); }
+
   /**
    * @brief Test if the given item is in the list or not
    *
@@ -535,7 +890,371 @@ public:
    */
   auto isin(const T &val) const noexcept { return map.count(val) > 0; }
 
+  /**
+   * @brief Test if the given item is in the list or not
+   *
+   * This is the same as above but the value may be of another type
+   * than T if the comparison object can compare it with T.
+   */
+  template <typename K> auto isin(const K &val) const {
+    return map.count(val) > 0;
+  }
+
+  /**
+   * @brief Test if given items are in the list or not
+   *
+   * If the map is sorted and there are many keys relative to the size
+   * of the list, the keys are sorted and merged with the map in one
+   * traversal.  Otherwise, each key is searched for.
+   *
+   * @param [in] n Number of keys.
+   * @param [in] key Function which returns the i-th key given i.
+   * @param [out] out Whether each key is in the list.  size: n
+   */
+  template <typename F>
+  void isin_many(size_t n, const F &key, bool *out) const {
+    search_many(n, key, [&](size_t i, const auto &k, auto it, bool final) {
+      out[i] = (it != std::end(map)) || (!final && isin(k));
+    });
+  }
+
+  /**
+   * @brief Return the position of an item in the list
+   *
+   * @param [in] val Value to search for.
+   *
+   * @return Position of the item equal to val, or size() if there is
+   *     no such item.
+   */
+  template <typename K> size_t index(const K &val) {
+    reindex();
+    return std::as_const(*this).index(val);
+  }
+
+  /**
+   * @brief Return the position of an item without renumbering
+   *
+   * This is the same as above but the positions must be numbered.
+   *
+   * @throw std::logic_error if `numbered()` is false.
+   */
+  template <typename K> size_t index(const K &val) const {
+    check_numbered();
+    auto [it, found] = find_or_hint(map, val);
+    return found ? position_of(it->second.link) : list.size();
+  }
+
+  /**
+   * @brief Return the positions of items in the list
+   *
+   * The keys are searched for as `isin_many` does.
+   *
+   * @param [in] n Number of keys.
+   * @param [in] key Function which returns the i-th key given i.
+   * @param [out] out Positions of the keys, or size() for the keys
+   *     not in the list.  size: n
+   */
+  template <typename F> void index_many(size_t n, const F &key, size_t *out) {
+    reindex();
+    std::as_const(*this).index_many(n, key, out);
+  }
+
+  /**
+   * @brief Return the positions of items without renumbering
+   *
+   * This is the same as above but the positions must be numbered.
+   *
+   * @throw std::logic_error if `numbered()` is false.
+   */
+  template <typename F>
+  void index_many(size_t n, const F &key, size_t *out) const {
+    check_numbered();
+    search_many(n, key, [&](size_t i, const auto &k, auto it, bool final) {
+      if (it != std::end(map)) {
+        out[i] = position_of(it->second.link);
+      } else {
+        out[i] = final ? list.size() : index(k);
+      }
+    });
+  }
+
+  /**
+   * @brief Add items given in the order of the map
+   *
+   * The keys sorted by `order` are merged with the map in one
+   * traversal, and the new keys are added at the end of the list in
+   * the order of their first occurrences, as calling `push_back` for
+   * each key does.  If there are few keys relative to the size of the
+   * list, each key is searched for by `lower_bound` from the root of
+   * the map instead.
+   * The map must be sorted by a comparison without a tolerance.
+   *
+   * @param [in] n Number of keys.
+   * @param [in] key Function which returns the i-th key given i.
+   * @param [in] order Permutation which sorts the keys stably in the
+   *     order of the map.  size: n
+   * @param [out] positions Position of each key in the list.  size: n
+   * @param [out] isnew Whether each key is added as a new one, which
+   *     is false for a key equal to an earlier one.  size: n
+   */
+  template <typename F, typename U>
+  void push_back_sorted(size_t n, const F &key, const U *order,
+                        size_t *positions, bool *isnew) {
+    using map_iterator = typename map_type::iterator;
+    auto comp = map.key_comp();
+    auto merge = prefers_merge(n);
+    std::vector<map_iterator> at(n);
+    auto it = std::begin(map);
+    for (size_t j = 0; j < n; ++j) {
+      auto i = static_cast<size_t>(order[j]);
+      auto k = key(i);
+      isnew[i] = false;
+      if (j > 0) {
+        auto prev = static_cast<size_t>(order[j - 1]);
+        if (!comp(key(prev), k)) { // Equal to the previous key.
+          at[i] = at[prev];
+          continue;
+        }
+      }
+      if (merge) {
+        while (it != std::end(map) && comp(it->first, k)) {
+          ++it;
+        }
+      } else {
+        it = map.lower_bound(k);
+      }
+      if (it != std::end(map) && !comp(k, it->first)) {
+        at[i] = it;
+      } else {
+        at[i] = map.emplace_hint(it, k, map_item_type{});
+        isnew[i] = true;
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (isnew[i]) {
+        at[i]->second.link = link(std::end(list), at[i]);
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      positions[i] = position_of(at[i]->second.link);
+    }
+  }
+
 private:
+  using list_iterator = typename list_type::iterator;
+
+  /**
+   * @brief Insert an item to the list
+   *
+   * The slots stay valid if the item is added at the end.
+   */
+  list_iterator link(list_iterator position,
+                     typename map_type::iterator it) {
+    auto at_end = position == std::end(list);
+    auto item = list.insert(position, list_item_type{it});
+    if (!at_end) {
+      indexed = false;
+    } else if (indexed) {
+      item->index = items.size();
+      items.push_back(item);
+      alive.push_back();
+    }
+    return item;
+  }
+
+  /**
+   * @brief Remove an item from the list
+   *
+   * The slot of the item is marked as erased in O(log n) time.  Once
+   * more than half of the slots are erased, the slots are renumbered
+   * on the next search for a position.
+   */
+  list_iterator unlink(list_iterator item) {
+    if (indexed) {
+      if (item->index + 1 == items.size()) {
+        items.pop_back();
+        alive.pop_back();
+      } else {
+        alive.reset(item->index);
+      }
+    }
+    auto next = list.erase(item);
+    if (items.size() > 2 * list.size() + 16) {
+      indexed = false;
+    }
+    return next;
+  }
+
+  /**
+   * @brief Return the position of an item in the list
+   *
+   * This takes constant time if no slot is erased and O(log n) time
+   * otherwise, unless the slots are renumbered.
+   */
+  size_t position_of(list_iterator item) {
+    reindex();
+    return std::as_const(*this).position_of(item);
+  }
+
+  /**
+   * @brief Return the position of an item if the slots are valid
+   */
+  size_t position_of(list_iterator item) const noexcept {
+    if (items.size() == list.size()) {
+      return item->index;
+    }
+    return alive.count(item->index);
+  }
+
+  /**
+   * @brief Return the slot of the item at a position
+   */
+  size_t slot_at(size_t position) const noexcept {
+    if (items.size() == list.size()) {
+      return position;
+    }
+    return alive.find(position);
+  }
+
+  /**
+   * @brief Raise an error if the slots are invalid
+   */
+  void check_numbered() const {
+    if (!indexed) {
+      throw std::logic_error("the positions must be renumbered");
+    }
+  }
+
+  /**
+   * @brief Renumber the items if the slots are invalid
+   */
+  void reindex() {
+    if (indexed) {
+      return;
+    }
+    items.clear();
+    items.reserve(list.size());
+    size_t i = 0;
+    for (auto x = std::begin(list); x != std::end(list); ++x) {
+      x->index = i++;
+      items.push_back(x);
+    }
+    alive.assign(items.size());
+    indexed = true;
+  }
+
+  /**
+   * @brief Search for keys by a sorted merge or one by one
+   *
+   * `f(i, key, it, final)` is called for each key, where `it` points to
+   * the element equal to the key or is the end of the map.  In a merge,
+   * the keys are sorted and compared with the elements visited in
+   * order.  A key is only matched with an element equal to it in both
+   * directions of the comparison.  Without a tolerance, a key missed in
+   * the merge is not in the map and `final` is true.  With a tolerance,
+   * the order of the keys may be inconsistent, so that a key missed
+   * next to an element within twice the tolerance is searched for
+   * again by `f`, for which `final` is false.  If the comparison object
+   * cannot widen its tolerance, every key missed is searched for again.
+   * The keys are not merged but searched for by `f` if the merge visits
+   * more elements.
+   */
+  template <typename F, typename G>
+  void search_many(size_t n, const F &key, const G &f) const {
+    using key_type = std::decay_t<decltype(key(size_t{0}))>;
+    if constexpr (detail::has_upper_bound<map_type, key_type>::value) {
+      if (prefers_merge(n)) {
+        std::vector<key_type> keys;
+        keys.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+          keys.push_back(key(i));
+        }
+        auto comp = map.key_comp();
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+          return comp(keys[a], keys[b]);
+        });
+        auto it = std::begin(map);
+        for (auto i : order) {
+          const auto &k = keys[i];
+          while (it != std::end(map) && !comp(k, it->first)) {
+            ++it;
+          }
+          auto found = std::end(map);
+          auto final = true;
+          if (it != std::begin(map) && !comp(std::prev(it)->first, k) &&
+              !comp(k, std::prev(it)->first)) {
+            found = std::prev(it);
+          } else if constexpr (!detail::is_exact<Compare>::value) {
+            if constexpr (detail::has_widened<Compare>::value) {
+              auto wide = comp.widened(2);
+              auto below = it == std::begin(map) ||
+                           wide(std::prev(it)->first, k);
+              final = below && (it == std::end(map) || wide(k, it->first));
+            } else {
+              final = false;
+            }
+          }
+          f(i, k, found, final);
+        }
+        return;
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      f(i, key(i), std::end(map), false);
+    }
+  }
+
+  /**
+   * @brief Test if merging n keys with the map visits fewer elements
+   *
+   * A search visits about log2(size()) elements and a merge all.
+   */
+  bool prefers_merge(size_t n) const noexcept {
+    size_t depth = 1;
+    for (auto m = map.size(); m > 1; m >>= 1) {
+      ++depth;
+    }
+    return map.size() < n * depth;
+  }
+
+  /**
+   * @brief Find an element equal to a given one or the insert position
+   *
+   * If the map is sorted, this finds the position as `std::map::insert`
+   * does, so that the result does not change when the comparison has
+   * a tolerance.  Otherwise, the hint is `end()`.
+   *
+   * @return Pair of an iterator and a flag.  If the flag is true,
+   *     the iterator points to the element equal to `val`.  Otherwise,
+   *     it is a hint to insert `val`.
+   */
+  template <typename K> auto find_or_hint(const K &val) {
+    return find_or_hint(map, val);
+  }
+
+  /**
+   * @brief Find an element equal to a given one in a map or a const map
+   */
+  template <typename M, typename K>
+  static auto find_or_hint(M &map, const K &val) {
+    using iterator = decltype(std::begin(map));
+    if constexpr (detail::has_upper_bound<map_type, K>::value) {
+      auto it = map.upper_bound(val);
+      if (it != std::begin(map)) {
+        auto prev = std::prev(it);
+        if (!map.key_comp()(prev->first, val)) {
+          return std::pair<iterator, bool>(prev, true);
+        }
+      }
+      return std::pair<iterator, bool>(it, false);
+    } else {
+      auto it = map.find(val);
+      return std::pair<iterator, bool>(it, it != std::end(map));
+    }
+  }
+
   /**
    * @brief Actual list to maintain elements.
    *
@@ -561,6 +1280,28 @@ private:
    */
   map_type map{};
 
+  /**
+   * @brief Whether `index` of the items in the list is valid
+   *
+   * `items` and `alive` are valid if and only if this is true.
+   */
+  bool indexed = true;
+
+  /**
+   * @brief Iterators to the items in the list by their slots
+   *
+   * The iterators in the erased slots are invalid.
+   */
+  std::vector<list_iterator> items{};
+
+  /**
+   * @brief Flags of the slots which are not erased
+   *
+   * The position of an item is the number of the flags set before its
+   * slot.
+   */
+  detail::fenwick_tree alive{};
+
 }; // struct uniquelist
 
 } // namespace uniquelist
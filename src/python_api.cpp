@@ -1,111 +1,1767 @@
+#include <algorithm>  // std::sort
+#include <cstdint>    // std::int32_t
+#include <functional> // std::less
 #include <iostream>
+#include <mutex>   // std::unique_lock
+#include <numeric> // std::iota
+#include <pybind11/eval.h>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <shared_mutex> // std::shared_mutex
+#include <sstream>
+#include <string>
+#include <string_view> // std::string_view
+#include <tuple>   // std::tie
+#include <utility> // std::index_sequence
+#include <vector>
 
+#include "uniquelist/compressed_ptr.h"
+#include "uniquelist/evaluate.h"
+#include "uniquelist/fixed_array.h"
+#include "uniquelist/gather.h"
+#include "uniquelist/grid_map.h"
+#include "uniquelist/kd_map.h"
+#include "uniquelist/permuted_less.h"
+#include "uniquelist/radix_sort.h"
+#include "uniquelist/scaled_ptr.h"
+#include "uniquelist/set_key.h"
+#include "uniquelist/shadowed_ptr.h"
 #include "uniquelist/sized_ptr.h"
+#include "uniquelist/sparse_ptr.h"
 #include "uniquelist/uniquelist.h"
 
+// Sizes of arrays for which UniqueFixedArrayList<N> are bound.
+// This can be configured by CMake variable UNIQUELIST_FIXED_SIZES.
+#ifndef UNIQUELIST_FIXED_SIZES
+#define UNIQUELIST_FIXED_SIZES 2, 3, 4, 8
+#endif
+
 namespace py = pybind11;
 
-using intlist = uniquelist::uniquelist<int>;
+/**
+ * @brief List with a reader/writer lock
+ *
+ * Each list bound to Python has its own lock, so that the module can
+ * be used without the GIL.  The methods which only read the list take
+ * the lock shared and the others take it exclusively.  A moved list
+ * gets a new lock.
+ */
+template <typename List> struct guarded : List {
+  using List::List;
+
+  guarded() = default;
+
+  guarded(guarded &&other) noexcept : List(std::move(other)) {}
+
+  mutable std::shared_mutex mutex;
+};
+
+template <typename T>
+using scalarlist =
+    guarded<uniquelist::uniquelist<T, uniquelist::scalar_less>>;
+
+/**
+ * @brief List of byte strings of a fixed width
+ *
+ * The keys are padded with null bytes to the width, as numpy does.
+ * The keys can be searched for by std::string_view.
+ */
+struct byteslist : guarded<uniquelist::uniquelist<std::string, std::less<>>> {
+  explicit byteslist(size_t width) : width{width} {}
+
+  size_t width;
+};
+
 using sized_ptr = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
-using arraylist = uniquelist::uniquelist<sized_ptr, uniquelist::strictly_less>;
+using arraylist =
+    guarded<uniquelist::uniquelist<sized_ptr, uniquelist::strictly_less>>;
+using gridarraylist =
+    guarded<uniquelist::uniquelist<sized_ptr, uniquelist::strictly_less,
+                                   uniquelist::grid_map>>;
+using metricarraylist =
+    guarded<uniquelist::uniquelist<sized_ptr, uniquelist::within_distance,
+                                   uniquelist::kd_map>>;
+using adaptivearraylist =
+    guarded<uniquelist::uniquelist<sized_ptr, uniquelist::permuted_less<>>>;
+using shadowed_ptr = uniquelist::shadowed_ptr<std::shared_ptr<double[]>>;
+using shadowedarraylist =
+    guarded<uniquelist::uniquelist<shadowed_ptr, uniquelist::strictly_less>>;
+using set_key = uniquelist::set_key<std::shared_ptr<std::int64_t[]>>;
+using setlist = guarded<uniquelist::uniquelist<set_key>>;
+using sparse_ptr = uniquelist::sparse_ptr<std::shared_ptr<double[]>,
+                                          std::shared_ptr<std::int32_t[]>>;
+using sparsearraylist =
+    guarded<uniquelist::uniquelist<sparse_ptr, uniquelist::strictly_less>>;
 
-// TODO Make UniqueList pickable.
+/**
+ * @brief List of arrays which are compressed when not used for a while
+ */
+struct compressedarraylist
+    : guarded<uniquelist::uniquelist<uniquelist::compressed_ptr<double>,
+                                     uniquelist::strictly_less>> {
+  compressedarraylist(double rtol, double atol, size_t compress_after)
+      : compressedarraylist::guarded{::uniquelist::strictly_less{rtol, atol}},
+        storage{compress_after} {}
 
-PYBIND11_MODULE(uniquelistpy, m) {
-  m.doc() = "uniquelist extension";
+  ::uniquelist::cold_storage<double> storage;
+};
 
-  py::class_<intlist>(m, "UniqueList")
-      .def(py::init<>())
-      .def("size", &intlist::size, "Return the number of items in the list")
-      .def(
-          "push_back", [](intlist &a, int x) { return a.push_back(x); },
-          "Add an item at the end of the list if it's new")
+/**
+ * @brief List of arrays which are unique up to a positive factor
+ */
+struct scaledarraylist
+    : guarded<uniquelist::uniquelist<
+          uniquelist::scaled_ptr<std::shared_ptr<double[]>>,
+          uniquelist::strictly_less>> {
+  scaledarraylist(double rtol, double atol, ::uniquelist::scaling mode)
+      : scaledarraylist::guarded{::uniquelist::strictly_less{rtol, atol}},
+        mode{mode} {}
+
+  ::uniquelist::scaling mode;
+};
+
+namespace {
+
+/**
+ * @brief Release the GIL and lock a list for reading
+ *
+ * The GIL is released before the lock is taken and taken back after
+ * the lock is released, so that a thread holding the lock never waits
+ * for a thread which holds the GIL and waits for the lock.
+ */
+template <typename List> struct read_guard {
+  explicit read_guard(const List &a) : lock{a.mutex} {}
+
+  py::gil_scoped_release release{};
+  std::shared_lock<std::shared_mutex> lock;
+};
+
+/**
+ * @brief Release the GIL and lock a list for writing
+ */
+template <typename List> struct write_guard {
+  explicit write_guard(List &a) : lock{a.mutex} {}
+
+  py::gil_scoped_release release{};
+  std::unique_lock<std::shared_mutex> lock;
+};
+
+/**
+ * @brief Whether searching a list modifies it
+ *
+ * The comparison of UniqueAdaptiveArrayList counts the elements read,
+ * so that the list is locked exclusively even to search it.
+ */
+template <typename List> struct search_writes : std::false_type {};
+
+template <> struct search_writes<adaptivearraylist> : std::true_type {};
+
+/**
+ * @brief Lock to search a list
+ */
+template <typename List>
+using search_guard = std::conditional_t<search_writes<List>::value,
+                                        write_guard<List>, read_guard<List>>;
+
+/**
+ * @brief Lock a list to find positions in it
+ *
+ * `f(a)` is called with the list as const under a shared lock, so that
+ * positions are found by several threads at the same time.  Only if
+ * the positions must be renumbered, after many items are erased, the
+ * list is locked exclusively to renumber them.
+ */
+template <typename List, typename F>
+auto with_positions(List &a, const F &f) {
+  if constexpr (!search_writes<List>::value) {
+    read_guard<List> guard{a};
+    if (a.numbered()) {
+      return f(static_cast<const List &>(a));
+    }
+  }
+  write_guard<List> guard{a};
+  a.renumber();
+  return f(static_cast<const List &>(a));
+}
+
+/**
+ * @brief Return the number of items in a list under its lock
+ */
+template <typename List> size_t locked_size(const List &a) {
+  read_guard<List> guard{a};
+  return a.size();
+}
+
+/**
+ * @brief Raise an error if the buffer is not of a given dimension
+ */
+void check_ndim(const py::buffer_info &info, py::ssize_t ndim) {
+  if (info.ndim != ndim) {
+    std::stringstream ss;
+    ss << "expected " << ndim << " dimensional but got " << info.ndim
+       << " dimensional";
+    throw std::invalid_argument(ss.str());
+  }
+}
+
+/**
+ * @brief Define methods to erase items
+ *
+ * This defines `erase` and `erase_nonzero` which are common to
+ * all lists.
+ */
+template <typename List, typename... Options>
+void def_erase(py::class_<List, Options...> &cls) {
+  cls.def(
+         "erase",
+         [](List &a, py::array_t<int> removed) {
+           auto removed_ = removed.request();
+           check_ndim(removed_, 1);
+           write_guard<List> guard{a};
+           a.erase(removed_.shape[0], static_cast<int *>(removed_.ptr));
+         },
+         "Erase items at given indexes")
       .def(
           "erase_nonzero",
-          [](intlist &a, py::array_t<int> removed) {
+          [](List &a, py::array_t<int> removed) {
             auto removed_ = removed.request();
-            return a.erase_nonzero(removed_.shape[0],
-                                   static_cast<int *>(removed_.ptr));
+            check_ndim(removed_, 1);
+            write_guard<List> guard{a};
+            if (static_cast<size_t>(removed_.shape[0]) != a.size()) {
+              std::stringstream ss;
+              ss << "expected size " << a.size() << " but got "
+                 << removed_.shape[0];
+              throw std::invalid_argument(ss.str());
+            }
+            a.erase_nonzero(removed_.shape[0],
+                            static_cast<int *>(removed_.ptr));
           },
-          "Erase items at given positions")
+          "Erase items at positions where flags are nonzeros");
+}
+
+/**
+ * @brief Reference count of an argument referenced only by the caller
+ *
+ * The count seen by a binding depends on how the Python version passes
+ * the arguments, so that this is measured when the module is imported.
+ */
+py::ssize_t sole_ref_count = 0;
+
+/**
+ * @brief Measure the reference count of an argument held by a variable
+ *
+ * This calls a function from Python with a variable in the same way as
+ * `lst.push_back(a, adopt=True)` and returns the reference count of
+ * the argument seen by the function.
+ */
+py::ssize_t measure_sole_ref_count() {
+  py::dict scope;
+  scope["probe"] = py::cpp_function(
+      [](py::object x, bool) { return x.ref_count(); }, py::arg("x"),
+      py::arg("adopt") = false);
+  py::exec(R"(
+def measure():
+    a = object()
+    return probe(a, adopt=True)
+)",
+           scope);
+  return scope["measure"]().cast<py::ssize_t>();
+}
+
+/**
+ * @brief Share the memory block of an array with a shared_ptr
+ *
+ * The returned shared_ptr keeps a reference to `array`, which is
+ * released by the deleter with the GIL held.
+ */
+std::shared_ptr<double[]> adopt_array(py::array array) {
+  auto ptr = static_cast<double *>(array.request().ptr);
+  auto obj = array.release();
+  return std::shared_ptr<double[]>(ptr, [obj](double *) {
+    py::gil_scoped_acquire gil;
+    obj.dec_ref();
+  });
+}
+
+/**
+ * @brief Create a read-only numpy array viewing an array in a list
+ *
+ * The numpy array shares the memory block and its base object keeps
+ * a copy of the shared_ptr, so that the view stays valid after the
+ * array is erased from the list.
+ */
+py::array view_array(const sized_ptr &x) {
+  auto owner = new std::shared_ptr<double[]>(x.ptr);
+  py::capsule base(owner, [](void *p) {
+    delete static_cast<std::shared_ptr<double[]> *>(p);
+  });
+  py::array_t<double> out({static_cast<py::ssize_t>(x.size)},
+                          {static_cast<py::ssize_t>(sizeof(double))},
+                          x.ptr.get(), base);
+  out.attr("setflags")(py::arg("write") = false);
+  return out;
+}
+
+/**
+ * @brief Iterator over a list which gets the items by position
+ *
+ * This calls `__getitem__` of the list with 0, 1, ... until it raises
+ * IndexError, so that it does not refer to the list after an item is
+ * erased, as the iterator of a Python list.
+ */
+struct item_iterator {
+  py::object list;
+  py::ssize_t next = 0;
+};
+
+/**
+ * @brief Define the access to the arrays in a list by position
+ *
+ * This defines `__len__`, `__getitem__` and `__iter__`.  The arrays
+ * are returned as read-only numpy arrays sharing the memory blocks.
+ */
+template <typename List, typename... Options>
+void def_views(py::class_<List, Options...> &cls) {
+  cls.def("__len__", &locked_size<List>)
       .def(
-          "index",
-          [](const intlist &a, int x) {
-            int i = 0;
-            for (auto item : a) {
-              if (item == x) {
-                return i;
+          "__getitem__",
+          [](List &a, py::ssize_t i) {
+            auto item = with_positions(a, [i](const List &a) {
+              auto n = static_cast<py::ssize_t>(a.size());
+              auto j = (i < 0) ? i + n : i;
+              if (j < 0 || j >= n) {
+                throw py::index_error("list index out of range");
+              }
+              return sized_ptr(a.at(static_cast<size_t>(j)));
+            });
+            return view_array(item);
+          },
+          py::arg("i"),
+          "Return the i-th array as a read-only view without copying it")
+      .def(
+          "__iter__", [](py::object a) { return item_iterator{a}; },
+          "Iterate over the arrays in the order of addition");
+}
+
+/**
+ * @brief Return true if `order` is "sorted" and false if "insertion"
+ */
+bool is_sorted_order(const std::string &order) {
+  if (order == "insertion") {
+    return false;
+  } else if (order == "sorted") {
+    return true;
+  }
+  throw std::invalid_argument(
+      "order must be 'insertion' or 'sorted' but got " + order);
+}
+
+/**
+ * @brief Collect the arrays of a list in the order of addition or keys
+ */
+template <typename List>
+auto layout_in_order(const List &a, bool sorted) {
+  if (sorted) {
+    return uniquelist::layout_of<double>(a.sbegin(), a.send());
+  }
+  return uniquelist::layout_of<double>(std::begin(a), std::end(a));
+}
+
+/**
+ * @brief Copy arrays of the same size to the rows of a matrix
+ *
+ * This is called without the GIL.  `out` is allocated with the GIL
+ * taken back and must outlive the release of the GIL, so that it is
+ * not destroyed without the GIL when an error is raised.
+ */
+void gather_rows(const uniquelist::array_layout<double> &layout,
+                 py::array_t<double> &out, unsigned threads) {
+  auto n = layout.size();
+  auto d = (n > 0) ? layout.size(0) : 0;
+  for (size_t i = 1; i < n; ++i) {
+    if (layout.size(i) != d) {
+      throw std::invalid_argument("all arrays must have the same size");
+    }
+  }
+  {
+    py::gil_scoped_acquire gil;
+    out = py::array_t<double>(
+        {static_cast<py::ssize_t>(n), static_cast<py::ssize_t>(d)});
+  }
+  uniquelist::gather(layout, out.mutable_data(), threads);
+}
+
+/**
+ * @brief Define the copy of the arrays in a list to numpy arrays
+ *
+ * This defines `to_numpy`, `to_csr` and `take`.
+ */
+template <typename List, typename... Options>
+void def_export(py::class_<List, Options...> &cls) {
+  cls.def(
+         "to_numpy",
+         [](const List &a, const std::string &order, unsigned threads) {
+           auto sorted = is_sorted_order(order);
+           py::array_t<double> out;
+           {
+             read_guard<List> guard{a};
+             gather_rows(layout_in_order(a, sorted), out, threads);
+           }
+           return out;
+         },
+         py::arg("order") = "insertion", py::arg("threads") = 0,
+         "Return the arrays as the rows of a 2 dimensional array.  "
+         "The rows are in the order of addition if order is "
+         "'insertion' and in the order of the keys if 'sorted'.  "
+         "All arrays must have the same size")
+      .def(
+          "to_csr",
+          [](const List &a, const std::string &order, unsigned threads) {
+            auto sorted = is_sorted_order(order);
+            py::array_t<double> data;
+            py::array_t<std::int64_t> offsets;
+            {
+              read_guard<List> guard{a};
+              auto layout = layout_in_order(a, sorted);
+              {
+                py::gil_scoped_acquire gil;
+                data = py::array_t<double>(
+                    static_cast<py::ssize_t>(layout.offsets.back()));
+                offsets = py::array_t<std::int64_t>(
+                    static_cast<py::ssize_t>(layout.offsets.size()));
+              }
+              std::copy(layout.offsets.begin(), layout.offsets.end(),
+                        offsets.mutable_data());
+              uniquelist::gather(layout, data.mutable_data(), threads);
+            }
+            return py::make_tuple(data, offsets);
+          },
+          py::arg("order") = "insertion", py::arg("threads") = 0,
+          "Return the arrays in the CSR format as data and offsets, "
+          "where the i-th array is data[offsets[i]:offsets[i + 1]]")
+      .def(
+          "take",
+          [](List &a,
+             py::array_t<std::int64_t,
+                         py::array::c_style | py::array::forcecast>
+                 indices,
+             unsigned threads) {
+            auto indices_ = indices.request();
+            check_ndim(indices_, 1);
+            auto p = static_cast<const std::int64_t *>(indices_.ptr);
+            std::vector<size_t> positions(indices_.shape[0]);
+            py::array_t<double> out;
+            with_positions(a, [&](const List &a) {
+              auto n = static_cast<std::int64_t>(a.size());
+              for (size_t i = 0; i < positions.size(); ++i) {
+                auto j = (p[i] < 0) ? p[i] + n : p[i];
+                if (j < 0 || j >= n) {
+                  throw py::index_error("list index out of range");
+                }
+                positions[i] = static_cast<size_t>(j);
+              }
+              gather_rows(uniquelist::layout_at<double>(
+                              a, positions.size(), positions.data()),
+                          out, threads);
+            });
+            return out;
+          },
+          py::arg("indices"), py::arg("threads") = 0,
+          "Return the arrays at given positions as the rows of a 2 "
+          "dimensional array.  Negative positions count from the end");
+}
+
+/**
+ * @brief Arrays given as the rows of a matrix or in the CSR format
+ *
+ * `batch(i)` returns a view of the i-th array.  The memory is owned by
+ * the numpy arrays, which must outlive the batch.
+ */
+struct array_batch {
+  size_t n = 0;
+  const double *data = nullptr;
+
+  /** Size of the rows, which is used if offsets is null. */
+  size_t d = 0;
+
+  /** The i-th array is data[offsets[i]:offsets[i + 1]] if not null. */
+  const std::int64_t *offsets = nullptr;
+
+  auto operator()(size_t i) const {
+    if (offsets) {
+      auto size = static_cast<size_t>(offsets[i + 1] - offsets[i]);
+      return uniquelist::as_view(size, data + offsets[i]);
+    }
+    return uniquelist::as_view(d, data + i * d);
+  }
+};
+
+/**
+ * @brief Create a batch of the rows of a 2 dimensional array
+ */
+array_batch rows_of(const py::buffer_info &matrix) {
+  check_ndim(matrix, 2);
+  return {static_cast<size_t>(matrix.shape[0]),
+          static_cast<const double *>(matrix.ptr),
+          static_cast<size_t>(matrix.shape[1])};
+}
+
+/**
+ * @brief Create a batch of arrays given in the CSR format
+ */
+array_batch csr_of(const py::buffer_info &data,
+                   const py::buffer_info &offsets) {
+  check_ndim(data, 1);
+  check_ndim(offsets, 1);
+  if (offsets.shape[0] < 1) {
+    throw std::invalid_argument("offsets must not be empty");
+  }
+  auto n = static_cast<size_t>(offsets.shape[0] - 1);
+  auto o = static_cast<const std::int64_t *>(offsets.ptr);
+  if (!std::is_sorted(o, o + n + 1) || o[0] < 0 || o[n] > data.shape[0]) {
+    throw std::invalid_argument(
+        "offsets must be nondecreasing and within data");
+  }
+  return {n, static_cast<const double *>(data.ptr), 0, o};
+}
+
+/**
+ * @brief Add arrays to a list in order
+ *
+ * `row(i)` returns a view of the i-th array, which is searched for
+ * without copying.  The new arrays are copied to memory blocks shared
+ * by them.  The blocks are allocated when needed, doubling in size but
+ * never larger than the arrays left in the batch, so that little memory
+ * is left unused.  A block is freed when all its arrays are erased.
+ * This does not touch Python objects and may be called without the GIL.
+ *
+ * @param [out] positions Positions of the arrays.  size: n
+ * @param [out] isnew Whether each array is new.  size: n
+ */
+template <typename List, typename F>
+void push_back_rows(List &a, size_t n, const F &row, std::int64_t *positions,
+                    bool *isnew) {
+  // Number of elements of the first block.
+  constexpr size_t first_block = size_t{1} << 12;
+  size_t left = 0;
+  for (size_t i = 0; i < n; ++i) {
+    left += row(i).size;
+  }
+  std::shared_ptr<double[]> block;
+  size_t capacity = 0;
+  size_t used = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto view = row(i);
+    auto [pos, status] = a.push_back_with_hook(view, [&](const auto &x) {
+      if (!block || used + x.size > capacity) {
+        capacity = std::min(left, std::max(2 * capacity, first_block));
+        capacity = std::max(capacity, x.size);
+        block.reset(new double[capacity]);
+        used = 0;
+      }
+      // Each array shares the ownership of the whole block.
+      std::shared_ptr<double[]> q{block, block.get() + used};
+      std::copy(x.ptr.get(), x.ptr.get() + x.size, q.get());
+      used += x.size;
+      return sized_ptr{x.size, std::move(q)};
+    });
+    positions[i] = static_cast<std::int64_t>(pos);
+    isnew[i] = status;
+    left -= view.size;
+  }
+}
+
+/**
+ * @brief Add a batch of arrays to a list
+ *
+ * @return Tuple of the positions and whether each array is new.
+ */
+template <typename List>
+py::tuple push_back_batch(List &a, const array_batch &batch) {
+  py::array_t<std::int64_t> positions(static_cast<py::ssize_t>(batch.n));
+  py::array_t<bool> isnew(static_cast<py::ssize_t>(batch.n));
+  auto positions_ = positions.mutable_data();
+  auto isnew_ = isnew.mutable_data();
+  {
+    write_guard<List> guard{a};
+    push_back_rows(a, batch.n, batch, positions_, isnew_);
+  }
+  return py::make_tuple(positions, isnew);
+}
+
+/**
+ * @brief Test if keys are in a list
+ *
+ * `key(i)` returns the i-th key, which is called without the GIL.
+ */
+template <typename List, typename F>
+py::array_t<bool> isin_keys(List &a, size_t n, const F &key) {
+  py::array_t<bool> out(static_cast<py::ssize_t>(n));
+  auto out_ = out.mutable_data();
+  {
+    search_guard<List> guard{a};
+    a.isin_many(n, key, out_);
+  }
+  return out;
+}
+
+/**
+ * @brief Return the positions of keys in a list, or -1 if missing
+ *
+ * `key(i)` returns the i-th key, which is called without the GIL.
+ */
+template <typename List, typename F>
+py::array_t<std::int64_t> index_keys(List &a, size_t n, const F &key) {
+  py::array_t<std::int64_t> out(static_cast<py::ssize_t>(n));
+  auto out_ = out.mutable_data();
+  with_positions(a, [&](const List &a) {
+    std::vector<size_t> positions(n);
+    a.index_many(n, key, positions.data());
+    for (size_t i = 0; i < n; ++i) {
+      out_[i] = (positions[i] < a.size())
+                    ? static_cast<std::int64_t>(positions[i])
+                    : -1;
+    }
+  });
+  return out;
+}
+
+/**
+ * @brief Test if arrays in a batch are in a list
+ */
+template <typename List>
+py::array_t<bool> isin_batch(List &a, const array_batch &batch) {
+  return isin_keys(a, batch.n, batch);
+}
+
+/**
+ * @brief Return the positions of arrays in a batch, or -1 if missing
+ */
+template <typename List>
+py::array_t<std::int64_t> index_batch(List &a, const array_batch &batch) {
+  return index_keys(a, batch.n, batch);
+}
+
+/**
+ * @brief Add items to a list in order
+ *
+ * `push(i)` adds the i-th item and returns the pair of its position
+ * and whether it is new, which is called without the GIL.
+ *
+ * @return Tuple of the positions and whether each item is new.
+ */
+template <typename List, typename F>
+py::tuple push_back_each(List &a, size_t n, const F &push) {
+  py::array_t<std::int64_t> positions(static_cast<py::ssize_t>(n));
+  py::array_t<bool> isnew(static_cast<py::ssize_t>(n));
+  auto positions_ = positions.mutable_data();
+  auto isnew_ = isnew.mutable_data();
+  {
+    write_guard<List> guard{a};
+    for (size_t i = 0; i < n; ++i) {
+      auto [pos, status] = push(i);
+      positions_[i] = static_cast<std::int64_t>(pos);
+      isnew_[i] = status;
+    }
+  }
+  return py::make_tuple(positions, isnew);
+}
+
+/**
+ * @brief Define the searches for batches of arrays
+ *
+ * This defines `isin_many` and `index_many`, which take a 2
+ * dimensional array of the arrays as rows, or the data and the
+ * offsets of arrays in the CSR format.
+ */
+template <typename List, typename... Options>
+void def_search(py::class_<List, Options...> &cls) {
+  using matrix_t =
+      py::array_t<double, py::array::c_style | py::array::forcecast>;
+  using offsets_t =
+      py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>;
+  cls.def(
+         "isin_many",
+         [](List &a, matrix_t matrix) {
+           return isin_batch(a, rows_of(matrix.request()));
+         },
+         py::arg("matrix"),
+         "Test if each row of a 2 dimensional array is in the list")
+      .def(
+          "isin_many",
+          [](List &a, matrix_t data, offsets_t offsets) {
+            return isin_batch(a, csr_of(data.request(), offsets.request()));
+          },
+          py::arg("data"), py::arg("offsets"),
+          "Test if each array given in the CSR format is in the list")
+      .def(
+          "index_many",
+          [](List &a, matrix_t matrix) {
+            return index_batch(a, rows_of(matrix.request()));
+          },
+          py::arg("matrix"),
+          "Return the positions of the rows of a 2 dimensional array "
+          "in the list, or -1 for the rows not in the list")
+      .def(
+          "index_many",
+          [](List &a, matrix_t data, offsets_t offsets) {
+            return index_batch(a, csr_of(data.request(), offsets.request()));
+          },
+          py::arg("data"), py::arg("offsets"),
+          "Return the positions of the arrays given in the CSR format "
+          "in the list, or -1 for the arrays not in the list");
+}
+
+/**
+ * @brief Parameters of a list saved by pickle
+ *
+ * `get` returns the parameters of the comparison as a tuple and
+ * `make` creates an empty list from them.
+ */
+template <typename List> struct pickle_config;
+
+template <> struct pickle_config<arraylist> {
+  static py::tuple get(const arraylist &a) {
+    auto comp = a.key_comp();
+    return py::make_tuple(comp.rtol, comp.atol);
+  }
+
+  static arraylist make(const py::tuple &t) {
+    return arraylist{uniquelist::strictly_less{t[0].cast<double>(),
+                                               t[1].cast<double>()}};
+  }
+};
+
+template <> struct pickle_config<gridarraylist> {
+  static py::tuple get(const gridarraylist &a) {
+    auto comp = a.key_comp();
+    auto options = a.get_map().grid_options();
+    return py::make_tuple(comp.rtol, comp.atol, options.cell_width,
+                          options.hashed_size);
+  }
+
+  static gridarraylist make(const py::tuple &t) {
+    return gridarraylist{
+        uniquelist::strictly_less{t[0].cast<double>(), t[1].cast<double>()},
+        uniquelist::grid_options{t[2].cast<double>(), t[3].cast<size_t>()}};
+  }
+};
+
+template <> struct pickle_config<metricarraylist> {
+  static py::tuple get(const metricarraylist &a) {
+    auto comp = a.key_comp();
+    return py::make_tuple(comp.eps, static_cast<int>(comp.norm));
+  }
+
+  static metricarraylist make(const py::tuple &t) {
+    auto norm = static_cast<uniquelist::within_distance::norm_type>(
+        t[1].cast<int>());
+    return metricarraylist{
+        uniquelist::within_distance{t[0].cast<double>(), norm}};
+  }
+};
+
+template <> struct pickle_config<adaptivearraylist> {
+  static py::tuple get(const adaptivearraylist &a) {
+    auto comp = a.key_comp();
+    py::object order = py::none();
+    if (comp.order) {
+      order = py::cast(*comp.order);
+    }
+    return py::make_tuple(comp.compare.rtol, comp.compare.atol, order);
+  }
+
+  static adaptivearraylist make(const py::tuple &t) {
+    std::shared_ptr<const std::vector<size_t>> order;
+    if (!t[2].is_none()) {
+      order = std::make_shared<const std::vector<size_t>>(
+          t[2].cast<std::vector<size_t>>());
+    }
+    return adaptivearraylist{uniquelist::permuted_less<>{
+        uniquelist::strictly_less{t[0].cast<double>(), t[1].cast<double>()},
+        order, std::make_shared<uniquelist::depth_stats>()}};
+  }
+};
+
+template <> struct pickle_config<shadowedarraylist> {
+  static py::tuple get(const shadowedarraylist &a) {
+    auto comp = a.key_comp();
+    return py::make_tuple(comp.rtol, comp.atol);
+  }
+
+  static shadowedarraylist make(const py::tuple &t) {
+    return shadowedarraylist{uniquelist::strictly_less{t[0].cast<double>(),
+                                                       t[1].cast<double>()}};
+  }
+};
+
+/**
+ * @brief Define pickling of a list of arrays
+ *
+ * The state is a tuple of the parameters, the arrays in the CSR format
+ * and the positions of the arrays.  The arrays are saved in the order
+ * of the map, so that the list is restored in linear time by
+ * `assign_sorted`.  The arrays are kept in numpy arrays, which are
+ * passed out-of-band with pickle protocol 5.  A list which is not
+ * `strictly_sorted` cannot be pickled, since some arrays would be lost
+ * in restoring it.
+ */
+template <typename List, typename... Options>
+void def_pickle(py::class_<List, Options...> &cls) {
+  cls.def(py::pickle(
+      [](List &a) {
+        py::tuple config;
+        py::array_t<double> data;
+        py::array_t<std::int64_t> offsets;
+        py::array_t<std::int64_t> positions;
+        {
+          // The positions may be renumbered, which modifies the list.
+          write_guard<List> guard{a};
+          if (!a.strictly_sorted()) {
+            throw std::runtime_error(
+                "the list cannot be pickled since an erase left arrays "
+                "equal within the tolerance next to each other");
+          }
+          auto layout = layout_in_order(a, true);
+          auto sorted = a.sorted_positions();
+          {
+            py::gil_scoped_acquire gil;
+            config = pickle_config<List>::get(a);
+            data = py::array_t<double>(
+                static_cast<py::ssize_t>(layout.offsets.back()));
+            offsets = py::array_t<std::int64_t>(
+                static_cast<py::ssize_t>(layout.offsets.size()));
+            positions =
+                py::array_t<std::int64_t>(static_cast<py::ssize_t>(a.size()));
+          }
+          std::copy(layout.offsets.begin(), layout.offsets.end(),
+                    offsets.mutable_data());
+          std::copy(sorted.begin(), sorted.end(), positions.mutable_data());
+          uniquelist::gather(layout, data.mutable_data());
+        }
+        return py::make_tuple(config, data, offsets, positions);
+      },
+      [](const py::tuple &state) {
+        if (state.size() != 4) {
+          throw std::runtime_error("invalid state");
+        }
+        auto a = pickle_config<List>::make(state[0].cast<py::tuple>());
+        using data_t =
+            py::array_t<double, py::array::c_style | py::array::forcecast>;
+        using index_t = py::array_t<std::int64_t, py::array::c_style |
+                                                      py::array::forcecast>;
+        auto data = state[1].cast<data_t>();
+        auto offsets = state[2].cast<index_t>();
+        auto positions = state[3].cast<index_t>();
+        auto batch = csr_of(data.request(), offsets.request());
+        auto positions_ = positions.request();
+        check_ndim(positions_, 1);
+        if (static_cast<size_t>(positions_.shape[0]) != batch.n) {
+          throw std::runtime_error("invalid state");
+        }
+        {
+          write_guard<List> guard{a};
+          // All arrays share one copy of the data.
+          auto total = static_cast<size_t>(batch.offsets[batch.n]);
+          std::shared_ptr<double[]> arena{new double[total]};
+          std::copy(batch.data, batch.data + total, arena.get());
+          auto removed = a.assign_sorted(
+              batch.n,
+              [&](size_t i) {
+                auto o = batch.offsets;
+                std::shared_ptr<double[]> p{arena, arena.get() + o[i]};
+                sized_ptr x{static_cast<size_t>(o[i + 1] - o[i]), std::move(p)};
+                if constexpr (std::is_same<typename List::value_type,
+                                           shadowed_ptr>::value) {
+                  return uniquelist::with_shadow(std::move(x));
+                } else {
+                  return x;
+                }
+              },
+              static_cast<const std::int64_t *>(positions_.ptr));
+          if (removed > 0) {
+            throw std::runtime_error("invalid state");
+          }
+        }
+        return a;
+      }));
+}
+
+/**
+ * @brief Bind a list of arrays of variable sizes
+ *
+ * This defines the methods common to the lists of sized_ptr.
+ * The constructors are defined by the caller.
+ */
+template <typename List>
+py::class_<List> bind_array_list(py::module_ &m, const char *name) {
+  py::class_<List> cls(m, name);
+  cls.def("size", &locked_size<List>,
+          "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](List &a, py::object array, bool adopt) {
+            // A view of the array or another variable holds a reference,
+            // through which the array may be written.
+            auto shared = array.ref_count() > sole_ref_count;
+            auto converted =
+                py::array_t<double, py::array::c_style |
+                                        py::array::forcecast>::ensure(array);
+            if (!converted) {
+              throw std::invalid_argument("expected an array of numbers");
+            }
+            auto array_ = converted.request();
+            check_ndim(array_, 1);
+            // The view is searched for without touching reference counts.
+            auto view =
+                uniquelist::as_view(static_cast<size_t>(array_.shape[0]),
+                                    static_cast<double *>(array_.ptr));
+            // A converted array is referenced only here.  Otherwise
+            // an array is adopted only if it owns its memory block and
+            // is not referenced elsewhere.
+            auto fresh = !converted.is(array);
+            if (!adopt || !(fresh || (converted.owndata() && !shared))) {
+              write_guard<List> guard{a};
+              return a.push_back_with_hook(view, [](const auto &x) {
+                return uniquelist::copy_as<std::shared_ptr<double[]>>(x);
+              });
+            }
+            write_guard<List> guard{a};
+            return a.push_back_with_hook(view, [&](const auto &x) {
+              // Adopting an array calls Python, which needs the GIL.
+              py::gil_scoped_acquire gil;
+              if (!fresh && converted.writeable()) {
+                converted.attr("setflags")(py::arg("write") = false);
+              }
+              return sized_ptr{x.size, adopt_array(converted)};
+            });
+          },
+          py::arg("array"), py::arg("adopt") = false,
+          "Add an item at the end of the list if its' new.  "
+          "If adopt is true, the list keeps a reference to the given "
+          "array instead of copying it and the array becomes read-only. "
+          "An array which is not contiguous, does not own its memory or "
+          "is referenced elsewhere, such as by a view, is still copied")
+      .def(
+          "push_back_many",
+          [](List &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 matrix) {
+            return push_back_batch(a, rows_of(matrix.request()));
+          },
+          py::arg("matrix"),
+          "Add the rows of a 2 dimensional array in order and return "
+          "the positions and whether each row is new as arrays.  "
+          "A row equal to an earlier row in the matrix gets the position "
+          "of the earlier one")
+      .def(
+          "push_back_csr",
+          [](List &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 data,
+             py::array_t<std::int64_t,
+                         py::array::c_style | py::array::forcecast>
+                 offsets) {
+            return push_back_batch(a,
+                                   csr_of(data.request(), offsets.request()));
+          },
+          py::arg("data"), py::arg("offsets"),
+          "Add arrays of various sizes given in the CSR format, where "
+          "the i-th array is data[offsets[i]:offsets[i + 1]], and return "
+          "the positions and whether each array is new as arrays")
+      .def(
+          "evaluate",
+          [](const List &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 x,
+             unsigned threads) {
+            auto x_ = x.request();
+            check_ndim(x_, 1);
+            py::array_t<double> out;
+            read_guard<List> guard{a};
+            {
+              // The lock is held, so taking the GIL cannot deadlock.
+              py::gil_scoped_acquire gil;
+              out = py::array_t<double>(static_cast<py::ssize_t>(a.size()));
+            }
+            uniquelist::evaluate(a, static_cast<const double *>(x_.ptr),
+                                 static_cast<size_t>(x_.shape[0]),
+                                 out.mutable_data(), threads);
+            return out;
+          },
+          py::arg("x"), py::arg("threads") = 0,
+          "Return the dot products of the items with x in the order of "
+          "addition.  All items must have the same size as x.  "
+          "threads=0 uses all hardware threads")
+      .def(
+          "most_violated",
+          [](const List &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 x,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 rhs,
+             size_t k, double tol, unsigned threads) {
+            auto x_ = x.request();
+            auto rhs_ = rhs.request();
+            check_ndim(x_, 1);
+            check_ndim(rhs_, 1);
+            std::vector<std::pair<size_t, double>> found;
+            {
+              read_guard<List> guard{a};
+              if (static_cast<size_t>(rhs_.shape[0]) != a.size()) {
+                std::stringstream ss;
+                ss << "expected rhs of size " << a.size() << " but got "
+                   << rhs_.shape[0];
+                throw std::invalid_argument(ss.str());
+              }
+              found = uniquelist::most_violated(
+                  a, static_cast<const double *>(x_.ptr),
+                  static_cast<size_t>(x_.shape[0]),
+                  static_cast<const double *>(rhs_.ptr), k, tol, threads);
+            }
+            auto n = static_cast<py::ssize_t>(found.size());
+            py::array_t<std::int64_t> positions(n);
+            py::array_t<double> violations(n);
+            auto positions_ = positions.mutable_data();
+            auto violations_ = violations.mutable_data();
+            for (size_t i = 0; i < found.size(); ++i) {
+              positions_[i] = static_cast<std::int64_t>(found[i].first);
+              violations_[i] = found[i].second;
+            }
+            return py::make_tuple(positions, violations);
+          },
+          py::arg("x"), py::arg("rhs"), py::arg("k"), py::arg("tol") = 0.0,
+          py::arg("threads") = 0,
+          "Regard the items as constraints a x <= rhs and return the "
+          "positions and the violations a x - rhs of at most k items "
+          "violated by more than tol, the largest first");
+  def_erase(cls);
+  def_views(cls);
+  def_export(cls);
+  def_search(cls);
+  return cls;
+}
+
+/**
+ * @brief Add a sparse array to a list
+ *
+ * The arrays `index` and `value` are only viewed and are deepcopied
+ * only if the array is new.
+ */
+auto push_back_sparse(sparsearraylist &a, size_t size, size_t nnz,
+                      std::int32_t *index, double *value) {
+  if (!uniquelist::is_valid_sparse_index(size, nnz, index)) {
+    throw std::invalid_argument(
+        "indices must be unique and smaller than dim");
+  }
+  sparse_ptr view{size, nnz, uniquelist::shared_ptr_without_ownership(index),
+                  uniquelist::shared_ptr_without_ownership(value)};
+  return a.push_back_with_hook(
+      view, uniquelist::deepcopy<std::shared_ptr<double[]>,
+                                 std::shared_ptr<std::int32_t[]>>);
+}
+
+/**
+ * @brief Define pickling of a list of keys
+ *
+ * The state is a tuple of the parameters, the keys in a numpy array in
+ * the order of the map and their positions, from which the list is
+ * restored in linear time by `assign_sorted`.  `save(a)` returns the
+ * pair of the parameters and the numpy array of the keys, `make`
+ * creates an empty list from the parameters and `load(a, obj, values)`
+ * converts the saved keys to a numpy array `values` and returns
+ * a function which returns the i-th key.
+ */
+template <typename List, typename Save, typename Make, typename Load>
+void def_key_pickle(py::class_<List> &cls, const Save &save,
+                    const Make &make, const Load &load) {
+  cls.def(py::pickle(
+      [save](List &a) {
+        py::object config;
+        py::array values;
+        py::array_t<std::int64_t> positions;
+        {
+          // The positions may be renumbered, which modifies the list.
+          write_guard<List> guard{a};
+          auto sorted = a.sorted_positions();
+          {
+            py::gil_scoped_acquire gil;
+            std::tie(config, values) = save(a);
+            positions = py::array_t<std::int64_t>(
+                static_cast<py::ssize_t>(a.size()));
+          }
+          std::copy(sorted.begin(), sorted.end(), positions.mutable_data());
+        }
+        return py::make_tuple(config, values, positions);
+      },
+      [make, load](const py::tuple &state) {
+        if (state.size() != 3) {
+          throw std::runtime_error("invalid state");
+        }
+        using index_t = py::array_t<std::int64_t, py::array::c_style |
+                                                      py::array::forcecast>;
+        auto a = make(state[0]);
+        py::array values;
+        auto key = load(a, state[1], values);
+        auto positions = state[2].cast<index_t>();
+        auto positions_ = positions.request();
+        check_ndim(positions_, 1);
+        if (values.ndim() != 1 || values.shape(0) != positions_.shape[0]) {
+          throw std::runtime_error("invalid state");
+        }
+        auto q = static_cast<const std::int64_t *>(positions_.ptr);
+        {
+          write_guard<List> guard{a};
+          if (a.assign_sorted(static_cast<size_t>(values.shape(0)), key,
+                              q) > 0) {
+            throw std::runtime_error("invalid state");
+          }
+        }
+        return a;
+      }));
+}
+
+/**
+ * @brief Bind a list of numbers of type T
+ */
+template <typename T>
+py::class_<scalarlist<T>> bind_scalar_list(py::module_ &m, const char *name) {
+  using List = scalarlist<T>;
+  using values_t = py::array_t<T, py::array::c_style | py::array::forcecast>;
+  py::class_<List> cls(m, name);
+  cls.def(py::init<>())
+      .def("size", &locked_size<List>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](List &a, T x) {
+            write_guard<List> guard{a};
+            return a.push_back(x);
+          },
+          "Add an item at the end of the list if it's new")
+      .def(
+          "push_back_many",
+          [](List &a, values_t values) {
+            auto values_ = values.request();
+            check_ndim(values_, 1);
+            auto p = static_cast<const T *>(values_.ptr);
+            return push_back_each(a, static_cast<size_t>(values_.shape[0]),
+                                  [&](size_t i) { return a.push_back(p[i]); });
+          },
+          py::arg("values"),
+          "Add the items of an array in order and return the positions "
+          "and whether each item is new as arrays")
+      .def(
+          "extend",
+          [](List &a, values_t values) {
+            auto values_ = values.request();
+            check_ndim(values_, 1);
+            auto n = static_cast<size_t>(values_.shape[0]);
+            auto p = static_cast<const T *>(values_.ptr);
+            py::array_t<std::int64_t> positions(values_.shape[0]);
+            py::array_t<bool> isnew(values_.shape[0]);
+            auto positions_ = positions.mutable_data();
+            auto isnew_ = isnew.mutable_data();
+            std::vector<size_t> order(n);
+            {
+              // Sort the items before locking the list.
+              py::gil_scoped_release release;
+              std::vector<decltype(uniquelist::radix_key(T{}))> keys(n);
+              for (size_t i = 0; i < n; ++i) {
+                keys[i] = uniquelist::radix_key(p[i]);
               }
-              ++i;
+              uniquelist::radix_sort(n, keys.data(), order.data());
             }
-            return -1;
+            {
+              write_guard<List> guard{a};
+              std::vector<size_t> out(n);
+              a.push_back_sorted(
+                  n, [p](size_t i) { return p[i]; }, order.data(),
+                  out.data(), isnew_);
+              std::copy(out.begin(), out.end(), positions_);
+            }
+            return py::make_tuple(positions, isnew);
+          },
+          py::arg("values"),
+          "Add the items of an array as push_back_many does, sorting "
+          "them by a radix sort and merging them with the list in one "
+          "traversal")
+      .def(
+          "index",
+          [](List &a, T x) {
+            return with_positions(a, [x](const List &a) {
+              auto i = a.index(x);
+              return (i < a.size()) ? static_cast<py::ssize_t>(i) : -1;
+            });
           },
           "Search a give item in the list and return its index")
+      .def(
+          "isin",
+          [](const List &a, T x) {
+            read_guard<List> guard{a};
+            return a.isin(x);
+          },
+          "Test if an item is in the list")
+      .def(
+          "isin_many",
+          [](List &a, values_t values) {
+            auto values_ = values.request();
+            check_ndim(values_, 1);
+            auto p = static_cast<const T *>(values_.ptr);
+            return isin_keys(a, static_cast<size_t>(values_.shape[0]),
+                             [p](size_t i) { return p[i]; });
+          },
+          py::arg("values"), "Test if each item of an array is in the list")
+      .def(
+          "index_many",
+          [](List &a, values_t values) {
+            auto values_ = values.request();
+            check_ndim(values_, 1);
+            auto p = static_cast<const T *>(values_.ptr);
+            return index_keys(a, static_cast<size_t>(values_.shape[0]),
+                              [p](size_t i) { return p[i]; });
+          },
+          py::arg("values"),
+          "Return the positions of the items of an array in the list, "
+          "or -1 for the items not in the list")
       .def(
           "display",
-          [](const intlist &a) {
+          [](const List &a) {
+            read_guard<List> guard{a};
             for (auto item : a) {
               std::cout << item << " ";
             }
             std::cout << std::endl;
           },
           "Print the items");
+  def_erase(cls);
+  def_key_pickle(
+      cls,
+      [](const List &a) {
+        py::array_t<T> values(static_cast<py::ssize_t>(a.size()));
+        std::copy(a.sbegin(), a.send(), values.mutable_data());
+        return std::make_pair(py::object(py::none()), py::array(values));
+      },
+      [](const py::handle &) { return List{}; },
+      [](const List &, py::handle obj, py::array &values) {
+        values = obj.cast<values_t>();
+        auto p = static_cast<const T *>(values.data());
+        return [p](size_t i) { return p[i]; };
+      });
+  return cls;
+}
 
-  py::class_<arraylist>(m, "UniqueArrayList")
-      .def(py::init<>())
-      .def("size", &arraylist::size, "Return the number of items in the list")
+/**
+ * @brief Convert an array to contiguous byte strings of a width
+ *
+ * Shorter byte strings are padded with null bytes.
+ *
+ * @throw std::invalid_argument if the array is not of byte strings or
+ *     they are longer than the width.
+ */
+py::array as_bytes_array(py::handle values, size_t width) {
+  auto numpy = py::module_::import("numpy");
+  py::array array = numpy.attr("asarray")(values);
+  auto dtype = array.dtype();
+  if (dtype.kind() != 'S') {
+    throw std::invalid_argument("expected an array of bytes");
+  }
+  if (static_cast<size_t>(dtype.itemsize()) > width) {
+    throw std::invalid_argument("bytes are longer than the width " +
+                                std::to_string(width));
+  }
+  return numpy.attr("ascontiguousarray")(
+      array, py::arg("dtype") = "S" + std::to_string(width));
+}
+
+/**
+ * @brief Pad a byte string with null bytes to the width of a list
+ */
+std::string pad_bytes(const std::string &x, size_t width) {
+  if (x.size() > width) {
+    throw std::invalid_argument("bytes are longer than the width " +
+                                std::to_string(width));
+  }
+  return x + std::string(width - x.size(), '\0');
+}
+
+/**
+ * @brief Bind a list of byte strings of a fixed width
+ */
+void bind_bytes_list(py::module_ &m) {
+  py::class_<byteslist> cls(m, "UniqueListBytes");
+  // View the i-th byte string of an array returned by as_bytes_array.
+  auto key = [](const py::buffer_info &values, size_t width) {
+    auto p = static_cast<const char *>(values.ptr);
+    return [p, width](size_t i) {
+      return std::string_view(p + i * width, width);
+    };
+  };
+  cls.def(py::init<size_t>(), py::arg("width"),
+          "Create a list of byte strings of at most width bytes")
+      .def_readonly("width", &byteslist::width)
+      .def("size", &locked_size<byteslist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](byteslist &a, const std::string &x) {
+            auto padded = pad_bytes(x, a.width);
+            write_guard<byteslist> guard{a};
+            return a.push_back(padded);
+          },
+          "Add an item at the end of the list if it's new")
+      .def(
+          "push_back_many",
+          [key](byteslist &a, py::object values) {
+            auto converted = as_bytes_array(values, a.width);
+            auto values_ = converted.request();
+            check_ndim(values_, 1);
+            auto k = key(values_, a.width);
+            return push_back_each(
+                a, static_cast<size_t>(values_.shape[0]), [&](size_t i) {
+                  return a.push_back_with_hook(
+                      k(i), [](std::string_view x) { return std::string(x); });
+                });
+          },
+          py::arg("values"),
+          "Add the items of an array of bytes in order and return the "
+          "positions and whether each item is new as arrays")
+      .def(
+          "index",
+          [](byteslist &a, const std::string &x) {
+            auto padded = pad_bytes(x, a.width);
+            return with_positions(a, [&padded](const byteslist &a) {
+              auto i = a.index(padded);
+              return (i < a.size()) ? static_cast<py::ssize_t>(i) : -1;
+            });
+          },
+          "Search a give item in the list and return its index")
+      .def(
+          "isin",
+          [](const byteslist &a, const std::string &x) {
+            auto padded = pad_bytes(x, a.width);
+            read_guard<byteslist> guard{a};
+            return a.isin(padded);
+          },
+          "Test if an item is in the list")
+      .def(
+          "isin_many",
+          [key](byteslist &a, py::object values) {
+            auto converted = as_bytes_array(values, a.width);
+            auto values_ = converted.request();
+            check_ndim(values_, 1);
+            return isin_keys(a, static_cast<size_t>(values_.shape[0]),
+                             key(values_, a.width));
+          },
+          py::arg("values"), "Test if each item of an array is in the list")
+      .def(
+          "index_many",
+          [key](byteslist &a, py::object values) {
+            auto converted = as_bytes_array(values, a.width);
+            auto values_ = converted.request();
+            check_ndim(values_, 1);
+            return index_keys(a, static_cast<size_t>(values_.shape[0]),
+                              key(values_, a.width));
+          },
+          py::arg("values"),
+          "Return the positions of the items of an array in the list, "
+          "or -1 for the items not in the list");
+  def_erase(cls);
+  def_key_pickle(
+      cls,
+      [](const byteslist &a) {
+        auto dtype = py::dtype("S" + std::to_string(a.width));
+        py::array values(dtype, {static_cast<py::ssize_t>(a.size())});
+        auto p = static_cast<char *>(values.mutable_data());
+        for (auto it = a.sbegin(); it != a.send(); ++it) {
+          p = std::copy(it->begin(), it->end(), p);
+        }
+        return std::make_pair(py::object(py::int_(a.width)), values);
+      },
+      [](const py::handle &config) {
+        return byteslist{config.cast<size_t>()};
+      },
+      [key](const byteslist &a, py::handle obj, py::array &values) {
+        values = as_bytes_array(obj, a.width);
+        return key(values.request(), a.width);
+      });
+}
+
+/**
+ * @brief Bind a list of arrays of size N
+ */
+template <size_t N> void bind_fixed_array_list(py::module_ &m) {
+  using fixed_array = uniquelist::fixed_array<double, N>;
+  using list =
+      guarded<uniquelist::uniquelist<fixed_array, uniquelist::strictly_less>>;
+  auto name = "UniqueFixedArrayList" + std::to_string(N);
+  py::class_<list> cls(m, name.c_str());
+  cls.def(py::init<>())
+      .def("size", &locked_size<list>,
+           "Return the number of items in the list")
       .def(
           "push_back",
-          [](arraylist &a, py::array_t<double> array) {
+          [](list &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 array) {
             auto array_ = array.request();
-            if (array_.ndim != 1) {
+            check_ndim(array_, 1);
+            if (array_.shape[0] != static_cast<py::ssize_t>(N)) {
               std::stringstream ss;
-              ss << "expected 1 dimensional but got " << array_.ndim
-                 << " dimensional";
+              ss << "expected size " << N << " but got " << array_.shape[0];
               throw std::invalid_argument(ss.str());
             }
-            auto view = uniquelist::shared_ptr_without_ownership(
-                static_cast<double *>(array_.ptr));
-            sized_ptr sized_ptr_view{static_cast<size_t>(array_.shape[0]),
-                                     view};
-            return a.push_back_with_hook(
-                sized_ptr_view,
-                uniquelist::deepcopy<std::shared_ptr<double[]>>);
+            write_guard<list> guard{a};
+            return a.push_back(uniquelist::as_fixed_array<N>(
+                static_cast<const double *>(array_.ptr)));
           },
-          "Add an item at the end of the list if its' new")
+          "Add an item at the end of the list if its' new");
+  def_erase(cls);
+}
+
+template <size_t... N>
+void bind_fixed_array_lists(py::module_ &m, std::index_sequence<N...>) {
+  (bind_fixed_array_list<N>(m), ...);
+}
+
+} // namespace
+
+PYBIND11_MODULE(uniquelistpy, m, py::mod_gil_not_used()) {
+  m.doc() = "uniquelist extension";
+  sole_ref_count = measure_sole_ref_count();
+
+  py::class_<item_iterator>(m, "ItemIterator")
+      .def("__iter__", [](py::object it) { return it; })
+      .def("__next__", [](item_iterator &it) {
+        try {
+          return it.list.attr("__getitem__")(it.next++);
+        } catch (py::error_already_set &e) {
+          if (e.matches(PyExc_IndexError)) {
+            throw py::stop_iteration();
+          }
+          throw;
+        }
+      });
+
+  bind_scalar_list<std::int32_t>(m, "UniqueListInt32");
+  bind_scalar_list<std::int64_t>(m, "UniqueListInt64");
+  bind_scalar_list<std::uint64_t>(m, "UniqueListUInt64");
+  bind_scalar_list<double>(m, "UniqueListFloat64");
+  bind_bytes_list(m);
+
+  m.def(
+      "UniqueList",
+      [](py::object dtype) -> py::object {
+        auto type = py::dtype::from_args(dtype);
+        auto kind = type.kind();
+        auto itemsize = type.itemsize();
+        if (kind == 'i' && itemsize == 4) {
+          return py::type::of<scalarlist<std::int32_t>>()();
+        } else if (kind == 'i' && itemsize == 8) {
+          return py::type::of<scalarlist<std::int64_t>>()();
+        } else if (kind == 'u' && itemsize == 8) {
+          return py::type::of<scalarlist<std::uint64_t>>()();
+        } else if (kind == 'f' && itemsize == 8) {
+          return py::type::of<scalarlist<double>>()();
+        } else if (kind == 'S' && itemsize > 0) {
+          return py::type::of<byteslist>()(itemsize);
+        }
+        throw std::invalid_argument(
+            "dtype must be int32, int64, uint64, float64 or bytes of a "
+            "fixed width but got " +
+            py::str(type).cast<std::string>());
+      },
+      py::arg("dtype") = "int32",
+      "Create a list of items of a given numpy dtype");
+
+  auto array_list = bind_array_list<arraylist>(m, "UniqueArrayList");
+  array_list.def(py::init([](double rtol, double atol) {
+                   return arraylist{uniquelist::strictly_less{rtol, atol}};
+                 }),
+                 py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6);
+  def_pickle(array_list);
+
+  auto grid_array_list =
+      bind_array_list<gridarraylist>(m, "UniqueGridArrayList");
+  grid_array_list
+      .def(py::init([](double rtol, double atol, double cell_width,
+                       size_t hashed_size) {
+             return gridarraylist{uniquelist::strictly_less{rtol, atol},
+                                  uniquelist::grid_options{cell_width,
+                                                           hashed_size}};
+           }),
+           py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6,
+           py::arg("cell_width") = 32.0, py::arg("hashed_size") = 8,
+           "Create a list which finds duplicates by hashing a tolerance grid");
+  def_pickle(grid_array_list);
+
+  auto metric_array_list =
+      bind_array_list<metricarraylist>(m, "UniqueMetricArrayList");
+  metric_array_list
+      .def(py::init([](double eps, const std::string &norm) {
+             uniquelist::within_distance::norm_type norm_;
+             if (norm == "l2") {
+               norm_ = uniquelist::within_distance::l2;
+             } else if (norm == "linf") {
+               norm_ = uniquelist::within_distance::linf;
+             } else {
+               throw std::invalid_argument(
+                   "norm must be 'l2' or 'linf' but got " + norm);
+             }
+             return metricarraylist{uniquelist::within_distance{eps, norm_}};
+           }),
+           py::arg("eps") = 1e-6, py::arg("norm") = "l2",
+           "Create a list which finds duplicates within a distance");
+  def_pickle(metric_array_list);
+
+  auto adaptive_array_list =
+      bind_array_list<adaptivearraylist>(m, "UniqueAdaptiveArrayList");
+  adaptive_array_list
+      .def(py::init([](double rtol, double atol) {
+             return adaptivearraylist{uniquelist::permuted_less<>{
+                 uniquelist::strictly_less{rtol, atol}, {},
+                 std::make_shared<uniquelist::depth_stats>()}};
+           }),
+           py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6,
+           "Create a list which compares the coordinates in the order "
+           "chosen by adapt")
       .def(
-          "erase",
-          [](arraylist &a, py::array_t<int> removed) {
-            auto removed_ = removed.request();
-            if (removed_.ndim != 1) {
-              std::stringstream ss;
-              ss << "expected 1 dimensional but got " << removed_.ndim
-                 << " dimensional";
-              throw std::invalid_argument(ss.str());
+          "adapt",
+          [](adaptivearraylist &a, size_t sample_size) {
+            write_guard<adaptivearraylist> guard{a};
+            return uniquelist::adapt_order(a, sample_size);
+          },
+          py::arg("sample_size") = 1024,
+          "Sample the arrays, order the coordinates by how well they "
+          "tell the arrays apart and rebuild the list if the order "
+          "changes.  Return true if the order is updated")
+      .def(
+          "comparison_depth",
+          [](const adaptivearraylist &a) {
+            uniquelist::depth_stats stats;
+            {
+              read_guard<adaptivearraylist> guard{a};
+              stats = *a.key_comp().stats;
             }
-            return a.erase(removed_.shape[0], static_cast<int *>(removed_.ptr));
+            return py::make_tuple(stats.comparisons, stats.scanned);
           },
-          "Erase items at given indexes")
+          "Return the number of comparisons and the number of elements "
+          "read in them")
       .def(
-          "erase_nonzero",
-          [](arraylist &a, py::array_t<int> removed) {
-            auto removed_ = removed.request();
-            if (removed_.ndim != 1) {
-              std::stringstream ss;
-              ss << "expected 1 dimensional but got " << removed_.ndim
-                 << " dimensional";
-              throw std::invalid_argument(ss.str());
+          "reset_comparison_depth",
+          [](adaptivearraylist &a) {
+            write_guard<adaptivearraylist> guard{a};
+            a.key_comp().stats->reset();
+          },
+          "Reset the counters of comparison_depth");
+  def_pickle(adaptive_array_list);
+
+  py::class_<sparsearraylist> sparse_array_list(m, "UniqueSparseArrayList");
+  sparse_array_list
+      .def(py::init([](double rtol, double atol) {
+             return sparsearraylist{uniquelist::strictly_less{rtol, atol}};
+           }),
+           py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6)
+      .def("size", &locked_size<sparsearraylist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](sparsearraylist &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 array) {
+            auto array_ = array.request();
+            check_ndim(array_, 1);
+            auto p = static_cast<double *>(array_.ptr);
+            auto size = static_cast<size_t>(array_.shape[0]);
+            write_guard<sparsearraylist> guard{a};
+            std::vector<std::int32_t> index;
+            std::vector<double> value;
+            for (size_t i = 0; i < size; ++i) {
+              if (p[i] != 0) {
+                index.push_back(static_cast<std::int32_t>(i));
+                value.push_back(p[i]);
+              }
             }
-            if (removed_.shape[0] != a.size()) {
-              std::stringstream ss;
-              ss << "expected size " << a.size() << " but got "
-                 << removed_.shape[0];
-              throw std::invalid_argument(ss.str());
+            return push_back_sparse(a, size, index.size(), index.data(),
+                                    value.data());
+          },
+          "Add a dense array at the end of the list if its' new")
+      .def(
+          "push_back_sparse",
+          [](sparsearraylist &a,
+             py::array_t<std::int32_t,
+                         py::array::c_style | py::array::forcecast>
+                 indices,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 values,
+             size_t dim) {
+            auto indices_ = indices.request();
+            auto values_ = values.request();
+            check_ndim(indices_, 1);
+            check_ndim(values_, 1);
+            if (indices_.shape[0] != values_.shape[0]) {
+              throw std::invalid_argument(
+                  "indices and values must have the same size");
+            }
+            auto nnz = static_cast<size_t>(indices_.shape[0]);
+            auto index = static_cast<std::int32_t *>(indices_.ptr);
+            auto value = static_cast<double *>(values_.ptr);
+            write_guard<sparsearraylist> guard{a};
+            if (std::is_sorted(index, index + nnz)) {
+              return push_back_sparse(a, dim, nnz, index, value);
             }
-            return a.erase_nonzero(removed_.shape[0],
-                                   static_cast<int *>(removed_.ptr));
+            // Sort the indices as a row of a CSR matrix may be unsorted.
+            std::vector<size_t> order(nnz);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(),
+                      [&](size_t i, size_t j) { return index[i] < index[j]; });
+            std::vector<std::int32_t> sorted_index(nnz);
+            std::vector<double> sorted_value(nnz);
+            for (size_t i = 0; i < nnz; ++i) {
+              sorted_index[i] = index[order[i]];
+              sorted_value[i] = value[order[i]];
+            }
+            return push_back_sparse(a, dim, nnz, sorted_index.data(),
+                                    sorted_value.data());
           },
-          "Erase items at positions where flags are nonzeros");
+          py::arg("indices"), py::arg("values"), py::arg("dim"),
+          "Add a sparse array given by the indices and the values of its "
+          "nonzero elements at the end of the list if its' new");
+  def_erase(sparse_array_list);
+
+  py::class_<compressedarraylist> compressed_array_list(
+      m, "UniqueCompressedArrayList");
+  compressed_array_list
+      .def(py::init<double, double, size_t>(), py::arg("rtol") = 1e-6,
+           py::arg("atol") = 1e-6, py::arg("compress_after") = 1024)
+      .def("size", &locked_size<compressedarraylist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](compressedarraylist &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 array) {
+            auto array_ = array.request();
+            check_ndim(array_, 1);
+            write_guard<compressedarraylist> guard{a};
+            auto view =
+                a.storage.view(static_cast<const double *>(array_.ptr),
+                               static_cast<size_t>(array_.shape[0]));
+            auto ret = a.push_back_with_hook(
+                view, [&a](const uniquelist::compressed_ptr<double> &x) {
+                  return a.storage.copy(x);
+                });
+            a.storage.tick();
+            return ret;
+          },
+          "Add an item at the end of the list if its' new")
+      .def(
+          "nbytes",
+          [](const compressedarraylist &a) {
+            read_guard<compressedarraylist> guard{a};
+            return a.storage.dense_bytes() + a.storage.compressed_bytes();
+          },
+          "Return the number of bytes used to keep the elements");
+  def_erase(compressed_array_list);
+
+  py::class_<scaledarraylist> scaled_array_list(m, "UniqueScaledArrayList");
+  scaled_array_list
+      .def(py::init([](double rtol, double atol, const std::string &scaling) {
+             if (scaling == "max_abs") {
+               return scaledarraylist{rtol, atol,
+                                      uniquelist::scaling::max_abs};
+             } else if (scaling == "first_nonzero") {
+               return scaledarraylist{rtol, atol,
+                                      uniquelist::scaling::first_nonzero};
+             }
+             throw std::invalid_argument(
+                 "scaling must be 'max_abs' or 'first_nonzero'");
+           }),
+           py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6,
+           py::arg("scaling") = "max_abs")
+      .def("size", &locked_size<scaledarraylist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](scaledarraylist &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 array) {
+            auto array_ = array.request();
+            check_ndim(array_, 1);
+            auto view = uniquelist::shared_ptr_without_ownership(
+                static_cast<double *>(array_.ptr));
+            write_guard<scaledarraylist> guard{a};
+            auto scaled_view = uniquelist::with_scale(
+                sized_ptr{static_cast<size_t>(array_.shape[0]), view},
+                a.mode);
+            return a.push_back_with_hook(scaled_view, [](const auto &x) {
+              return uniquelist::deepcopy(x);
+            });
+          },
+          "Add an item at the end of the list if no item in the list is "
+          "equal to it up to a positive factor");
+  def_erase(scaled_array_list);
+
+  py::class_<shadowedarraylist> shadowed_array_list(
+      m, "UniqueShadowedArrayList");
+  shadowed_array_list
+      .def(py::init([](double rtol, double atol) {
+             return shadowedarraylist{uniquelist::strictly_less{rtol, atol}};
+           }),
+           py::arg("rtol") = 1e-6, py::arg("atol") = 1e-6,
+           "Create a list which compares float32 copies of the arrays "
+           "first and reads the original arrays only if necessary")
+      .def("size", &locked_size<shadowedarraylist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](shadowedarraylist &a,
+             py::array_t<double, py::array::c_style | py::array::forcecast>
+                 array) {
+            auto array_ = array.request();
+            check_ndim(array_, 1);
+            auto view = uniquelist::shared_ptr_without_ownership(
+                static_cast<double *>(array_.ptr));
+            write_guard<shadowedarraylist> guard{a};
+            // The shadow of the probe is kept if the array is new.
+            auto shadowed_view = uniquelist::with_shadow(
+                sized_ptr{static_cast<size_t>(array_.shape[0]), view});
+            return a.push_back_with_hook(shadowed_view, [](const auto &x) {
+              return uniquelist::deepcopy(x);
+            });
+          },
+          "Add an item at the end of the list if its' new");
+  def_erase(shadowed_array_list);
+  def_views(shadowed_array_list);
+  def_export(shadowed_array_list);
+  def_pickle(shadowed_array_list);
+
+  py::class_<setlist> set_list(m, "UniqueSetList");
+  set_list.def(py::init<>())
+      .def("size", &locked_size<setlist>,
+           "Return the number of items in the list")
+      .def(
+          "push_back",
+          [](setlist &a,
+             py::array_t<std::int64_t,
+                         py::array::c_style | py::array::forcecast>
+                 array) {
+            auto array_ = array.request();
+            check_ndim(array_, 1);
+            auto p = static_cast<const std::int64_t *>(array_.ptr);
+            write_guard<setlist> guard{a};
+            std::vector<std::int64_t> buf(p, p + array_.shape[0]);
+            auto n = uniquelist::canonicalize(buf.data(), buf.size());
+            auto view = uniquelist::as_set_key(
+                n, uniquelist::shared_ptr_without_ownership(buf.data()));
+            return a.push_back_with_hook(view, [](const set_key &x) {
+              return uniquelist::deepcopy(x);
+            });
+          },
+          "Add a set of integers at the end of the list if its' new. "
+          "The order and duplicates of the integers are ignored");
+  def_erase(set_list);
+
+  bind_fixed_array_lists(m, std::index_sequence<UNIQUELIST_FIXED_SIZES>{});
 }
@@ -18,6 +18,26 @@ def main():
         return
     test_int_list()
     test_array_list()
+    test_fixed_array_list()
+    test_grid_array_list()
+    test_metric_array_list()
+    test_sparse_array_list()
+    test_compressed_array_list()
+    test_scaled_array_list()
+    test_set_list()
+    test_adaptive_array_list()
+    test_shadowed_array_list()
+    test_evaluate()
+    test_push_back_many()
+    test_push_back_csr()
+    test_threads()
+    test_shared_list()
+    test_views()
+    test_export()
+    test_search()
+    test_pickle()
+    test_dtypes()
+    test_extend()
 
 
 def test_int_list():
@@ -64,6 +84,537 @@ def test_array_list():
     np.testing.assert_equal(x, (2, True))
     np.testing.assert_equal(lst.size(), 3)
 
+    # Adopted arrays are not copied but become read-only.
+    lst = uniquelistpy.UniqueArrayList()
+    a = np.array([1.0, 2.0])
+    x = lst.push_back(a, adopt=True)
+    np.testing.assert_equal(x, (0, True))
+    assert not a.flags.writeable
+    b = np.array([1.0, 2.0])
+    x = lst.push_back(b, adopt=True)
+    np.testing.assert_equal(x, (0, False))
+    assert b.flags.writeable
+    # Slices and converted arrays are copied.
+    c = np.arange(6.0)
+    x = lst.push_back(c[::2], adopt=True)
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back(c[:2], adopt=True)
+    np.testing.assert_equal(x, (2, True))
+    assert c.flags.writeable
+    c[:] = -1
+    x = lst.push_back(np.arange(0, 6, 2), adopt=True)
+    np.testing.assert_equal(x, (1, False))
+    x = lst.push_back([0, 1], adopt=True)
+    np.testing.assert_equal(x, (2, False))
+    # Arrays viewed by other arrays are copied, since the key could be
+    # written through the view.
+    d = np.array([7.0, 8.0])
+    v = d[:]
+    position, isnew = lst.push_back(d, adopt=True)
+    assert isnew
+    assert d.flags.writeable
+    v[0] = -7.0
+    np.testing.assert_equal(lst[position], [7.0, 8.0])
+    np.testing.assert_equal(lst.push_back([7.0, 8.0]), (position, False))
+    del v
+    # Non-contiguous arrays are read correctly.
+    x = lst.push_back(np.array([[1.0, 0.0], [2.0, 0.0]])[:, 0])
+    np.testing.assert_equal(x, (0, False))
+    del a
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 2)
+
+
+def test_fixed_array_list():
+    lst = uniquelistpy.UniqueFixedArrayList3()
+    np.testing.assert_equal(lst.size(), 0)
+    x = lst.push_back([0, 1.5, 2])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([2, 1, 2.1])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back([0, 1.5, 2])
+    np.testing.assert_equal(x, (0, False))
+    np.testing.assert_equal(lst.size(), 2)
+    try:
+        lst.push_back([0, 1.5])
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("expected ValueError")
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 1)
+
+
+def test_grid_array_list():
+    lst = uniquelistpy.UniqueGridArrayList(rtol=0, atol=1e-3)
+    x = lst.push_back([0, 1.5, 2])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([0.0004, 1.5, 2])
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back([0.0004, 1.5])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back([0.0004, 1.6, 2])
+    np.testing.assert_equal(x, (2, True))
+    np.testing.assert_equal(lst.size(), 3)
+    lst.erase_nonzero([1, 0, 0])
+    np.testing.assert_equal(lst.size(), 2)
+    x = lst.push_back([0.0004, 1.5, 2])
+    np.testing.assert_equal(x, (2, True))
+
+
+def test_metric_array_list():
+    lst = uniquelistpy.UniqueMetricArrayList(eps=0.1, norm="linf")
+    x = lst.push_back([0, 0])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([0.09, -0.09])
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back([0.11, 0])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back([0])
+    np.testing.assert_equal(x, (2, True))
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 2)
+    x = lst.push_back([0.05, 0])
+    np.testing.assert_equal(x, (0, False))
+
+
+def test_sparse_array_list():
+    lst = uniquelistpy.UniqueSparseArrayList()
+    x = lst.push_back_sparse([2, 5], [1.0, -1.0], 10)
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back_sparse([5, 2], [-1.0, 1.0], 10)
+    np.testing.assert_equal(x, (0, False))
+    dense = np.zeros(10)
+    dense[[2, 5]] = [1.0, -1.0]
+    x = lst.push_back(dense)
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back_sparse([2, 5, 7], [1.0, -1.0, 0.0], 10)
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back_sparse([2, 5], [1.0, -1.0], 11)
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back_sparse([], [], 10)
+    np.testing.assert_equal(x, (2, True))
+    np.testing.assert_raises(
+        ValueError, lst.push_back_sparse, [2, 10], [1.0, 1.0], 10
+    )
+    np.testing.assert_raises(
+        ValueError, lst.push_back_sparse, [2, 2], [1.0, 1.0], 10
+    )
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 2)
+
+
+def test_compressed_array_list():
+    lst = uniquelistpy.UniqueCompressedArrayList(compress_after=10)
+    rng = np.random.default_rng(0)
+    arrays = rng.integers(-3, 4, size=(100, 50)).astype(float)
+    arrays[rng.random(arrays.shape) < 0.8] = 0
+    for i, a in enumerate(arrays):
+        np.testing.assert_equal(lst.push_back(a), (i, True))
+    for _ in range(200):
+        lst.push_back(arrays[0])
+    np.testing.assert_array_less(lst.nbytes() * 3, arrays.nbytes)
+    for i, a in enumerate(arrays):
+        np.testing.assert_equal(lst.push_back(a), (i, False))
+    x = lst.push_back(arrays[0] + 1e-3)
+    np.testing.assert_equal(x, (100, True))
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 100)
+
+
+def test_scaled_array_list():
+    lst = uniquelistpy.UniqueScaledArrayList()
+    x = lst.push_back([1.0, -2.0, 3.0])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([0.1, -0.2, 0.3])
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back([-1.0, 2.0, -3.0])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back([0.0, 0.0, 0.0])
+    np.testing.assert_equal(x, (2, True))
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 2)
+    x = lst.push_back([3.0, -6.0, 9.0])
+    np.testing.assert_equal(x, (2, True))
+
+    lst = uniquelistpy.UniqueScaledArrayList(scaling="first_nonzero")
+    x = lst.push_back([0.0, 4.0, 1.0])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([0.0, 2.0, 0.5])
+    np.testing.assert_equal(x, (0, False))
+    np.testing.assert_raises(
+        ValueError, uniquelistpy.UniqueScaledArrayList, scaling="l2"
+    )
+
+
+def test_set_list():
+    lst = uniquelistpy.UniqueSetList()
+    x = lst.push_back([3, 1, 2])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back(np.array([2, 1, 3, 3]))
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back([1, 2])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back(np.arange(20)[::-1])
+    np.testing.assert_equal(x, (2, True))
+    x = lst.push_back(np.arange(20))
+    np.testing.assert_equal(x, (2, False))
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 2)
+
+
+def test_adaptive_array_list():
+    rng = np.random.default_rng(0)
+    arrays = np.ones((500, 30))
+    arrays[:, -3:] = rng.integers(0, 5, size=(500, 3))
+    lst = uniquelistpy.UniqueAdaptiveArrayList()
+    before = [lst.push_back(x) for x in arrays]
+    np.testing.assert_equal(lst.adapt(), True)
+    np.testing.assert_equal(lst.adapt(), False)
+    lst.reset_comparison_depth()
+    after = [lst.push_back(x) for x in arrays]
+    np.testing.assert_equal([x[0] for x in after], [x[0] for x in before])
+    comparisons, scanned = lst.comparison_depth()
+    assert scanned < 5 * comparisons
+
+
+def test_shadowed_array_list():
+    lst = uniquelistpy.UniqueShadowedArrayList()
+    x = lst.push_back([2.9, -1.0, 4.9])
+    np.testing.assert_equal(x, (0, True))
+    x = lst.push_back([2.9, -1.0, 4.8999999999])
+    np.testing.assert_equal(x, (0, False))
+    x = lst.push_back([2.9, -1.0, 4.90001])
+    np.testing.assert_equal(x, (1, True))
+    x = lst.push_back([1e300, 0.0])
+    np.testing.assert_equal(x, (2, True))
+    x = lst.push_back([1.1e300, 0.0])
+    np.testing.assert_equal(x, (3, True))
+    lst.erase([0])
+    np.testing.assert_equal(lst.size(), 3)
+
+
+def test_evaluate():
+    rng = np.random.default_rng(0)
+    arrays = rng.normal(size=(100, 7))
+    lst = uniquelistpy.UniqueArrayList()
+    for x in arrays:
+        lst.push_back(x)
+    x = rng.normal(size=7)
+    np.testing.assert_allclose(lst.evaluate(x), arrays @ x)
+    np.testing.assert_allclose(lst.evaluate(x, threads=2), arrays @ x)
+    rhs = np.ones(100)
+    positions, violations = lst.most_violated(x, rhs, 3)
+    expected = np.argsort(-(arrays @ x - rhs))[:3]
+    np.testing.assert_equal(positions, expected)
+    np.testing.assert_allclose(violations, (arrays @ x - rhs)[expected])
+    positions, violations = lst.most_violated(x, rhs + 100, 3)
+    np.testing.assert_equal(positions.size, 0)
+
+
+def test_push_back_many():
+    lst = uniquelistpy.UniqueArrayList()
+    lst.push_back([1.0, 2.0])
+    matrix = np.array(
+        [
+            [3.0, 4.0],
+            [1.0, 2.0000000001],
+            [5.0, 6.0],
+            [3.0, 4.0],
+        ]
+    )
+    positions, isnew = lst.push_back_many(matrix)
+    np.testing.assert_equal(positions, [1, 0, 2, 1])
+    np.testing.assert_equal(isnew, [True, False, True, False])
+    np.testing.assert_equal(lst.size(), 3)
+    matrix[0, 0] = 100.0
+    np.testing.assert_equal(lst.push_back([3.0, 4.0]), (1, False))
+    positions, isnew = lst.push_back_many(np.zeros((0, 2)))
+    np.testing.assert_equal(positions.size, 0)
+
+    # New arrays are copied to several memory blocks.
+    rng = np.random.default_rng(0)
+    matrix = rng.integers(0, 100, size=(20000, 3)).astype(float)
+    positions, isnew = lst.push_back_many(matrix)
+    for i in range(0, len(matrix), 97):
+        np.testing.assert_equal(lst[positions[i]], matrix[i])
+    lst.erase(np.sort(positions[isnew])[::2].astype(np.int32))
+    np.testing.assert_equal(lst.index_many(matrix) >= 0, lst.isin_many(matrix))
+
+def test_push_back_csr():
+    lst = uniquelistpy.UniqueArrayList()
+    lst.push_back([1.0])
+    data = np.array([1.0, 2.0, 3.0, 2.0, 3.0, 4.0, 5.0, 6.0])
+    offsets = np.array([0, 1, 3, 5, 5, 8])
+    positions, isnew = lst.push_back_csr(data, offsets)
+    np.testing.assert_equal(positions, [0, 1, 1, 2, 3])
+    np.testing.assert_equal(isnew, [False, True, False, True, True])
+    data[:] = -1.0
+    np.testing.assert_equal(lst.push_back([4.0, 5.0, 6.0]), (3, False))
+    try:
+        lst.push_back_csr(data, np.array([0, 3, 2]))
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("expected ValueError")
+
+
+def test_threads():
+    # Lists used by different threads must not interfere.
+    import threading
+
+    rng = np.random.default_rng(0)
+    matrices = [rng.integers(0, 3, size=(2000, 4)) for _ in range(4)]
+    lists = [uniquelistpy.UniqueArrayList() for _ in matrices]
+    results = [None] * len(lists)
+
+    def run(i):
+        positions, isnew = lists[i].push_back_many(matrices[i])
+        lists[i].erase_nonzero(np.zeros(lists[i].size(), dtype=np.int32))
+        results[i] = positions
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for matrix, positions in zip(matrices, results):
+        _, expected = np.unique(matrix, axis=0, return_index=True)
+        np.testing.assert_equal(np.unique(positions).size, expected.size)
+
+
+def test_shared_list():
+    # One list used by several threads keeps each row once.
+    import threading
+
+    rng = np.random.default_rng(0)
+    matrices = [rng.integers(0, 3, size=(2000, 4)) for _ in range(4)]
+    shared = uniquelistpy.UniqueArrayList()
+    results = [None] * len(matrices)
+
+    def run(i):
+        positions, _ = shared.push_back_many(matrices[i])
+        shared.size()
+        results[i] = positions
+
+    threads = [
+        threading.Thread(target=run, args=(i,)) for i in range(len(matrices))
+    ]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    expected = np.unique(np.concatenate(matrices), axis=0).shape[0]
+    np.testing.assert_equal(shared.size(), expected)
+    for matrix, positions in zip(matrices, results):
+        for row, position in zip(matrix[:10], positions[:10]):
+            found, _ = shared.push_back(row)
+            np.testing.assert_equal(found, position)
+
+
+def test_views():
+    lst = uniquelistpy.UniqueArrayList()
+    a = np.array([1.0, 2.0, 3.0])
+    lst.push_back(a)
+    lst.push_back(np.array([4.0, 5.0]))
+    lst.push_back(np.array([6.0]))
+    np.testing.assert_equal(len(lst), 3)
+    np.testing.assert_equal(lst[0], a)
+    np.testing.assert_equal(lst[-1], [6.0])
+    assert not lst[1].flags.writeable
+    # The items are views of the memory in the list, not copies.
+    x, y = lst[1], lst[1]
+    assert x is not y
+    assert np.shares_memory(x, y)
+    assert not np.shares_memory(lst[0], a)
+    first = lst[0]
+    lst.erase_nonzero(np.array([1, 0, 0], dtype=np.int32))
+    # The view keeps the erased array alive, even if new arrays are
+    # allocated afterwards.
+    for i in range(100):
+        lst.push_back(np.full(3, -1.0 - i))
+    np.testing.assert_equal(first, a)
+    lst.erase(np.arange(2, lst.size(), dtype=np.int32))
+    np.testing.assert_equal([x.tolist() for x in lst], [[4.0, 5.0], [6.0]])
+    try:
+        lst[2]
+    except IndexError:
+        pass
+    else:
+        raise AssertionError("expected IndexError")
+
+
+def test_export():
+    lst = uniquelistpy.UniqueArrayList()
+    lst.push_back(np.array([3.0, 1.0]))
+    lst.push_back(np.array([1.0, 2.0]))
+    lst.push_back(np.array([2.0, 0.0]))
+    np.testing.assert_equal(lst.to_numpy(), [[3, 1], [1, 2], [2, 0]])
+    np.testing.assert_equal(
+        lst.to_numpy(order="sorted"), [[1, 2], [2, 0], [3, 1]]
+    )
+    np.testing.assert_equal(lst.take([2, -3, 2]), [[2, 0], [3, 1], [2, 0]])
+    lst.push_back(np.array([5.0]))
+    data, offsets = lst.to_csr()
+    np.testing.assert_equal(data, [3, 1, 1, 2, 2, 0, 5])
+    np.testing.assert_equal(offsets, [0, 2, 4, 6, 7])
+    try:
+        lst.to_numpy()
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("expected ValueError")
+
+
+def test_search():
+    lst = uniquelistpy.UniqueList()
+    for x in [5, 3, 9, 1]:
+        lst.push_back(x)
+    assert lst.isin(9)
+    values = np.array([1, 2, 3, 9, 10, 5] * 10)
+    np.testing.assert_equal(
+        lst.isin_many(values), [True, False, True, True, False, True] * 10
+    )
+    np.testing.assert_equal(lst.index_many(values), [3, -1, 1, 2, -1, 0] * 10)
+
+    rng = np.random.default_rng(0)
+    matrix = rng.integers(0, 4, size=(300, 3)).astype(float)
+    lst = uniquelistpy.UniqueArrayList()
+    lst.push_back_many(matrix[:100])
+    queries = rng.integers(0, 4, size=(20, 3)).astype(float)
+    for batch in [queries, np.tile(queries, (50, 1))]:
+        expected = np.array([lst.index_many(q[None])[0] for q in batch])
+        np.testing.assert_equal(lst.index_many(batch), expected)
+        np.testing.assert_equal(lst.isin_many(batch), expected >= 0)
+    for row, position in zip(queries, lst.index_many(queries)):
+        if position >= 0:
+            np.testing.assert_equal(lst[position], row)
+    data = np.array([1.0, 2.0, 0.0, 1.0, 2.0])
+    offsets = np.array([0, 2, 5])
+    position, _ = lst.push_back(np.array([0.0, 1.0, 2.0]))
+    np.testing.assert_equal(lst.index_many(data, offsets)[1], position)
+
+
+def test_pickle():
+    import pickle
+
+    lst = uniquelistpy.UniqueList()
+    for x in [5, 3, 9, 1]:
+        lst.push_back(x)
+    lst.erase_nonzero(np.array([0, 1, 0, 0], dtype=np.int32))
+    restored = pickle.loads(pickle.dumps(lst))
+    np.testing.assert_equal(restored.index_many([5, 9, 1, 3]), [0, 1, 2, -1])
+    np.testing.assert_equal(restored.push_back(7), (3, True))
+
+    rng = np.random.default_rng(0)
+    matrix = rng.integers(0, 4, size=(200, 3)).astype(float)
+    for lst in [
+        uniquelistpy.UniqueArrayList(rtol=0, atol=1e-3),
+        uniquelistpy.UniqueGridArrayList(rtol=0, atol=1e-3, cell_width=4),
+        uniquelistpy.UniqueMetricArrayList(eps=1e-3, norm="linf"),
+        uniquelistpy.UniqueAdaptiveArrayList(),
+        uniquelistpy.UniqueShadowedArrayList(),
+    ]:
+        lst.push_back_many(matrix)
+        lst.push_back(np.array([1.0, 2.0]))
+        if hasattr(lst, "adapt"):
+            lst.adapt()
+        buffers = []
+        payload = pickle.dumps(lst, protocol=5, buffer_callback=buffers.append)
+        # The arrays are passed out-of-band.
+        assert len(buffers) > 0
+        restored = pickle.loads(payload, buffers=buffers)
+        np.testing.assert_equal(restored.size(), lst.size())
+        for a, b in zip(lst, restored):
+            np.testing.assert_equal(a, b)
+        np.testing.assert_equal(
+            restored.index_many(matrix), lst.index_many(matrix)
+        )
+
+    # An erase may leave two arrays equal within the tolerance next to
+    # each other in the map, which cannot be restored.
+    lst = uniquelistpy.UniqueArrayList(rtol=0, atol=1)
+    for x in [[2.0, -5.0], [0.0, 0.0], [1.0, 0.0]]:
+        lst.push_back(np.array(x))
+    lst.erase_nonzero(np.array([1, 0, 0], dtype=np.int32))
+    np.testing.assert_raises(RuntimeError, pickle.dumps, lst)
+
+
+def test_dtypes():
+    import pickle
+
+    lst = uniquelistpy.UniqueList(dtype=np.int64)
+    assert lst.push_back(2**40) == (0, True)
+    assert lst.push_back(2**40 + 1) == (1, True)
+    assert lst.index(2**40 + 1) == 1
+
+    lst = uniquelistpy.UniqueList(dtype="uint64")
+    lst.push_back(2**64 - 1)
+    assert lst.isin(2**64 - 1)
+
+    lst = uniquelistpy.UniqueList(dtype=np.float64)
+    values = np.array([1.5, np.nan, -0.5, np.nan, 1.5])
+    positions, isnew = lst.push_back_many(values)
+    np.testing.assert_equal(positions, [0, 1, 2, 1, 0])
+    np.testing.assert_equal(isnew, [True, True, True, False, False])
+    assert lst.isin(np.nan)
+    np.testing.assert_equal(lst.index_many([np.nan, 2.0]), [1, -1])
+    restored = pickle.loads(pickle.dumps(lst))
+    np.testing.assert_equal(restored.index_many(values), positions)
+
+    lst = uniquelistpy.UniqueList(dtype="S4")
+    assert lst.width == 4
+    assert lst.push_back(b"ab") == (0, True)
+    positions, isnew = lst.push_back_many(np.array([b"abcd", b"ab", b"x"]))
+    np.testing.assert_equal(positions, [1, 0, 2])
+    np.testing.assert_equal(isnew, [True, False, True])
+    np.testing.assert_equal(lst.isin_many([b"x", b"y"]), [True, False])
+    assert lst.index(b"abcd") == 1
+    try:
+        lst.push_back(b"abcde")
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("expected ValueError")
+    lst.erase_nonzero(np.array([1, 0, 0], dtype=np.int32))
+    restored = pickle.loads(pickle.dumps(lst))
+    np.testing.assert_equal(
+        restored.index_many([b"abcd", b"x", b"ab"]), [0, 1, -1]
+    )
+
+    try:
+        uniquelistpy.UniqueList(dtype=np.int16)
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("expected ValueError")
+
+
+def test_extend():
+    rng = np.random.default_rng(0)
+    for dtype in [np.int32, np.int64, np.uint64, np.float64]:
+        values = rng.integers(0, 1000, size=5000).astype(dtype)
+        if dtype == np.float64:
+            values[::7] = np.nan
+            values[::11] = -0.0
+        expected = uniquelistpy.UniqueList(dtype=dtype)
+        lst = uniquelistpy.UniqueList(dtype=dtype)
+        for x in values[:100]:
+            expected.push_back(x)
+            lst.push_back(x)
+        for batch in [values[:10], values]:
+            positions, isnew = lst.extend(batch)
+            expected_positions, expected_isnew = expected.push_back_many(
+                batch
+            )
+            np.testing.assert_equal(positions, expected_positions)
+            np.testing.assert_equal(isnew, expected_isnew)
+        assert lst.size() == expected.size()
+    lst = uniquelistpy.UniqueList()
+    positions, isnew = lst.extend([3, 1, 3, 2])
+    np.testing.assert_equal(positions, [0, 1, 0, 2])
+    np.testing.assert_equal(isnew, [True, True, False, True])
+
 
 if __name__ == "__main__":
     main()
@@ -1,5 +1,10 @@
+#include <algorithm> // std::fill, std::stable_sort
 #include <iostream>
-#include <iterator> // std::back_inserter
+#include <iterator>  // std::back_inserter
+#include <memory>    // std::unique_ptr
+#include <numeric>   // std::iota
+#include <random>
+#include <stdexcept> // std::out_of_range, std::logic_error
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -121,3 +126,265 @@ TEST(TestUtilsUniqueList, TestUniquelist) {
     }
   }
 }
+
+TEST(TestUtilsUniqueList, TestUniquelistPositions) {
+  // The positions are cached and must follow insertions and removals
+  // in the middle of the list.
+  uniquelist::uniquelist<int> list;
+  std::vector<int> expected;
+  for (int i = 0; i < 100; ++i) {
+    list.push_back(i);
+    expected.push_back(i);
+  }
+  int erased[] = {3, 10, 50};
+  list.erase(3, erased);
+  expected.erase(expected.begin() + 50);
+  expected.erase(expected.begin() + 10);
+  expected.erase(expected.begin() + 3);
+  list.insert(std::begin(list), 1000);
+  expected.insert(expected.begin(), 1000);
+  list.erase(list.size() - 1);
+  expected.pop_back();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    auto [pos, isnew] = list.push_back(expected[i]);
+    EXPECT_EQ(pos, i);
+    EXPECT_EQ(isnew, 0);
+  }
+  auto [pos, isnew] = list.push_back(2000);
+  EXPECT_EQ(pos, expected.size());
+  EXPECT_EQ(isnew, 1);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistAt) {
+  // Elements are looked up by position after removals and insertions
+  // in the middle of the list.
+  uniquelist::uniquelist<int> list;
+  std::vector<int> expected;
+  for (int i = 0; i < 100; ++i) {
+    list.push_back(i);
+    expected.push_back(i);
+  }
+  EXPECT_EQ(list.at(42), 42);
+  list.erase(42);
+  expected.erase(expected.begin() + 42);
+  list.insert(std::begin(list), 1000);
+  expected.insert(expected.begin(), 1000);
+  // The const versions do not renumber the positions, which is needed
+  // after many items are erased.
+  const auto &view = list;
+  EXPECT_TRUE(list.numbered());
+  EXPECT_EQ(view.at(43), 43);
+  std::vector<int> flags(list.size(), 0);
+  std::fill(flags.begin(), flags.begin() + 80, 1);
+  list.erase_nonzero(flags.size(), flags.data());
+  expected.erase(expected.begin(), expected.begin() + 80);
+  EXPECT_FALSE(list.numbered());
+  EXPECT_THROW(view.at(0), std::logic_error);
+  EXPECT_THROW(view.index(expected[0]), std::logic_error);
+  list.renumber();
+  EXPECT_TRUE(list.numbered());
+  EXPECT_EQ(view.at(0), expected[0]);
+  EXPECT_EQ(view.index(expected[5]), 5);
+  list.push_back(2000);
+  expected.push_back(2000);
+  list.erase(list.size() - 1);
+  expected.pop_back();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(list.at(i), expected[i]);
+  }
+  EXPECT_THROW(list.at(expected.size()), std::out_of_range);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistAtRandomErase) {
+  // The positions stay right after random removals, which only mark
+  // the slots as erased, and occasional insertions in the middle.
+  std::mt19937 engine(0);
+  uniquelist::uniquelist<int> list;
+  std::vector<int> expected;
+  for (int step = 0; step < 3000; ++step) {
+    auto action = engine() % 8;
+    if (action < 4 || expected.empty()) {
+      int x = static_cast<int>(engine() % 1000);
+      auto [pos, isnew] = list.push_back(x);
+      if (isnew) {
+        expected.push_back(x);
+      }
+      EXPECT_EQ(expected[pos], x);
+    } else if (action < 7) {
+      auto i = engine() % expected.size();
+      list.erase(i);
+      expected.erase(expected.begin() + static_cast<long>(i));
+    } else if (step % 50 == 0) {
+      auto i = engine() % expected.size();
+      auto it = std::begin(list);
+      std::advance(it, i);
+      list.insert(it, -step);
+      expected.insert(expected.begin() + static_cast<long>(i), -step);
+    }
+    ASSERT_EQ(list.size(), expected.size());
+    if (!expected.empty()) {
+      auto i = engine() % expected.size();
+      EXPECT_EQ(list.at(i), expected[i]);
+      EXPECT_EQ(list.index(expected[i]), i);
+    }
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(list.at(i), expected[i]);
+  }
+  auto sorted = list.sorted_positions();
+  size_t j = 0;
+  for (auto it = list.sbegin(); it != list.send(); ++it, ++j) {
+    EXPECT_EQ(expected[sorted[j]], *it);
+  }
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistIndexMany) {
+  // A few keys are searched for one by one and many keys are merged
+  // with the map.  Both must agree with index.
+  uniquelist::uniquelist<int> list;
+  for (int i = 0; i < 100; ++i) {
+    list.push_back((i * 37) % 100 * 2);
+  }
+  int erased[] = {5, 17};
+  list.erase(2, erased);
+  for (size_t n : {3, 500}) {
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = static_cast<int>((i * 7919) % 220);
+    }
+    auto key = [&](size_t i) { return keys[i]; };
+    std::vector<size_t> positions(n);
+    std::unique_ptr<bool[]> found{new bool[n]};
+    list.index_many(n, key, positions.data());
+    list.isin_many(n, key, found.get());
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(positions[i], list.index(keys[i]));
+      EXPECT_EQ(found[i], list.isin(keys[i]));
+      if (found[i]) {
+        EXPECT_EQ(list.at(positions[i]), keys[i]);
+      } else {
+        EXPECT_EQ(positions[i], list.size());
+      }
+    }
+  }
+}
+
+namespace {
+
+/**
+ * @brief Exact comparison which counts the comparisons made
+ */
+struct counting_less {
+  using is_exact = void;
+
+  std::shared_ptr<size_t> count = std::make_shared<size_t>(0);
+
+  bool operator()(int a, int b) const {
+    ++*count;
+    return a < b;
+  }
+};
+
+} // namespace
+
+TEST(TestUtilsUniqueList, TestUniquelistIndexManyExact) {
+  // Without a tolerance, the keys missed in a merge are not searched
+  // for again, so that the merge makes about n + size() comparisons
+  // after sorting the keys.
+  counting_less comp;
+  uniquelist::uniquelist<int, counting_less> list{comp};
+  for (int i = 0; i < 100; ++i) {
+    list.push_back(i * 2);
+  }
+  size_t n = 500;
+  std::vector<int> keys(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = static_cast<int>((i * 7919) % 401);
+  }
+  auto key = [&](size_t i) { return keys[i]; };
+  std::vector<int> sorted = keys;
+  *comp.count = 0;
+  std::stable_sort(sorted.begin(), sorted.end(), comp);
+  auto sort_count = *comp.count;
+
+  std::vector<size_t> positions(n);
+  std::unique_ptr<bool[]> found{new bool[n]};
+  *comp.count = 0;
+  list.index_many(n, key, positions.data());
+  EXPECT_LE(*comp.count, sort_count + 3 * n + list.size());
+  *comp.count = 0;
+  list.isin_many(n, key, found.get());
+  EXPECT_LE(*comp.count, sort_count + 3 * n + list.size());
+  for (size_t i = 0; i < n; ++i) {
+    auto expected = (keys[i] % 2 == 0 && keys[i] < 200)
+                        ? static_cast<size_t>(keys[i] / 2)
+                        : list.size();
+    EXPECT_EQ(positions[i], expected);
+    EXPECT_EQ(found[i], expected < list.size());
+  }
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistAssignSorted) {
+  // A list is restored from its elements in the order of the map and
+  // their positions.
+  uniquelist::uniquelist<int> list;
+  for (int x : {5, 3, 9, 1, 7}) {
+    list.push_back(x);
+  }
+  int erased[] = {1};
+  list.erase(1, erased);
+  std::vector<int> keys(list.sbegin(), list.send());
+  auto positions = list.sorted_positions();
+  EXPECT_EQ(keys, (std::vector<int>{1, 5, 7, 9}));
+  EXPECT_EQ(positions, (std::vector<size_t>{2, 0, 3, 1}));
+
+  uniquelist::uniquelist<int> restored;
+  restored.push_back(100);
+  auto removed = restored.assign_sorted(
+      keys.size(), [&](size_t i) { return keys[i]; }, positions.data());
+  EXPECT_EQ(removed, 0);
+  EXPECT_EQ(std::vector<int>(std::begin(restored), std::end(restored)),
+            (std::vector<int>{5, 9, 1, 7}));
+  EXPECT_EQ(restored.push_back(7).first, 3);
+  EXPECT_EQ(restored.push_back(8).first, 4);
+
+  int invalid[] = {0, 0, 1, 2};
+  EXPECT_THROW(restored.assign_sorted(
+                   4, [&](size_t i) { return keys[i]; }, invalid),
+               std::invalid_argument);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistPushBackSorted) {
+  for (bool large : {false, true}) {
+    uniquelist::uniquelist<int> list;
+    list.push_back(4);
+    list.push_back(1);
+    if (large) {
+      // Few keys relative to the list are searched for one by one.
+      for (int x = 100; x < 200; ++x) {
+        list.push_back(x);
+      }
+    }
+    std::vector<int> keys = {7, 1, 3, 7, 0, 3};
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](auto a, auto b) { return keys[a] < keys[b]; });
+    std::vector<size_t> positions(keys.size());
+    bool isnew[6];
+    list.push_back_sorted(
+        keys.size(), [&](size_t i) { return keys[i]; }, order.data(),
+        positions.data(), isnew);
+
+    // The same as push_back of each key.
+    auto n = large ? 102u : 2u;
+    EXPECT_EQ(positions,
+              (std::vector<size_t>{n, 1, n + 1, n, n + 2, n + 1}));
+    EXPECT_EQ(std::vector<bool>(isnew, isnew + 6),
+              (std::vector<bool>{true, false, true, false, true, false}));
+    EXPECT_EQ(list.size(), n + 3);
+    EXPECT_EQ(list.at(n + 2), 0);
+    EXPECT_EQ(list.index(3), n + 1);
+    EXPECT_EQ(list.push_back(0).first, n + 2);
+  }
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/evaluate.h"
+#include "uniquelist/parallel.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestParallelFor) {
+  std::vector<int> visited(1000, 0);
+  uniquelist::parallel_for(
+      visited.size(), 10,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          ++visited[i];
+        }
+      },
+      4);
+  EXPECT_EQ(visited, std::vector<int>(1000, 1));
+
+  std::atomic<int> calls{0};
+  EXPECT_THROW(uniquelist::parallel_for(
+                   100, 1,
+                   [&](size_t, size_t) {
+                     ++calls;
+                     throw std::runtime_error("error");
+                   },
+                   4),
+               std::runtime_error);
+  EXPECT_EQ(calls, 4);
+}
+
+TEST(TestUtilsUniqueList, TestEvaluate) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+  const size_t n = 1003;
+  const size_t d = 37;
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  for (size_t i = 0; i < n; ++i) {
+    std::shared_ptr<double[]> p{new double[d]};
+    for (size_t j = 0; j < d; ++j) {
+      p[j] = dist(engine);
+    }
+    list.push_back(array{d, p});
+  }
+  std::vector<double> x(d);
+  for (auto &v : x) {
+    v = dist(engine);
+  }
+
+  std::vector<double> expected;
+  for (const auto &a : list) {
+    double sum = 0;
+    for (size_t j = 0; j < d; ++j) {
+      sum += a.ptr[j] * x[j];
+    }
+    expected.push_back(sum);
+  }
+  for (unsigned threads : {1u, 3u}) {
+    std::vector<double> out(n);
+    uniquelist::evaluate(list, x.data(), d, out.data(), threads);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(out[i], expected[i], 1e-12);
+    }
+  }
+
+  std::vector<double> rhs(n, 1.0);
+  auto violated = uniquelist::most_violated(list, x.data(), d, rhs.data(), 5);
+  ASSERT_EQ(violated.size(), 5);
+  std::vector<double> sorted = expected;
+  std::sort(sorted.begin(), sorted.end(), std::greater<double>());
+  for (size_t i = 0; i < violated.size(); ++i) {
+    EXPECT_NEAR(violated[i].second, sorted[i] - 1.0, 1e-12);
+    EXPECT_NEAR(expected[violated[i].first], sorted[i], 1e-12);
+  }
+  auto none = uniquelist::most_violated(list, x.data(), d, rhs.data(), 5,
+                                        sorted.front());
+  EXPECT_TRUE(none.empty());
+
+  list.push_back(uniquelist::as_sized_ptr({1.0}));
+  std::vector<double> out(list.size());
+  EXPECT_THROW(uniquelist::evaluate(list, x.data(), d, out.data()),
+               std::invalid_argument);
+}
@@ -0,0 +1,62 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/gather.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestGather) {
+  using sized_ptr = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<sized_ptr, uniquelist::strictly_less> list;
+  std::vector<std::vector<double>> arrays = {
+      {3, 1}, {1, 2, 3}, {0}, {3, 1}, {2, 2}};
+  for (const auto &a : arrays) {
+    list.push_back_with_hook(
+        uniquelist::as_view(a.size(), a.data()), [](const auto &x) {
+          return uniquelist::copy_as<std::shared_ptr<double[]>>(x);
+        });
+  }
+  auto check = [](const uniquelist::array_layout<double> &layout,
+                  const std::vector<double> &expected) {
+    std::vector<double> out(layout.offsets.back());
+    uniquelist::gather(layout, out.data(), 2);
+    EXPECT_EQ(out, expected);
+  };
+
+  auto inserted =
+      uniquelist::layout_of<double>(std::begin(list), std::end(list));
+  EXPECT_EQ(inserted.offsets, (std::vector<size_t>{0, 2, 5, 6, 8}));
+  check(inserted, {3, 1, 1, 2, 3, 0, 2, 2});
+
+  // The arrays are sorted by size first.
+  const auto &view = list;
+  auto sorted = uniquelist::layout_of<double>(view.sbegin(), view.send());
+  check(sorted, {0, 2, 2, 3, 1, 1, 2, 3});
+
+  long positions[] = {3, 0, 3};
+  auto taken = uniquelist::layout_at<double>(list, 3, positions);
+  check(taken, {2, 2, 3, 1, 2, 2});
+
+  long invalid[] = {4};
+  EXPECT_THROW(uniquelist::layout_at<double>(list, 1, invalid),
+               std::out_of_range);
+}
+
+TEST(TestUtilsUniqueList, TestGatherLarge) {
+  // Enough arrays to be split into several chunks.
+  std::vector<std::vector<double>> arrays(5000, std::vector<double>(64));
+  uniquelist::array_layout<double> layout;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    arrays[i][i % 64] = static_cast<double>(i);
+    layout.rows.push_back(arrays[i].data());
+    layout.offsets.push_back(layout.offsets.back() + 64);
+  }
+  std::vector<double> out(layout.offsets.back());
+  uniquelist::gather(layout, out.data(), 4);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    EXPECT_EQ(out[i * 64 + i % 64], static_cast<double>(i));
+  }
+}
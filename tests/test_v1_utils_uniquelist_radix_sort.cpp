@@ -0,0 +1,58 @@
+#include <algorithm> // std::stable_sort
+#include <cstdint>
+#include <limits>
+#include <numeric> // std::iota
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/radix_sort.h"
+
+TEST(TestUtilsUniqueList, TestRadixKey) {
+  auto inf = std::numeric_limits<double>::infinity();
+  auto nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> values = {-inf, -2.5, -1e-300, -0.0, 0.0,
+                                1e-300, 3.0, inf, nan};
+  for (size_t i = 0; i + 1 < values.size(); ++i) {
+    EXPECT_LE(uniquelist::radix_key(values[i]),
+              uniquelist::radix_key(values[i + 1]));
+  }
+  EXPECT_EQ(uniquelist::radix_key(-0.0), uniquelist::radix_key(0.0));
+  EXPECT_EQ(uniquelist::radix_key(nan), uniquelist::radix_key(-nan));
+  EXPECT_LT(uniquelist::radix_key(std::int64_t{-1}),
+            uniquelist::radix_key(std::int64_t{0}));
+  EXPECT_LT(uniquelist::radix_key(std::numeric_limits<std::int32_t>::min()),
+            uniquelist::radix_key(std::int32_t{-1}));
+  EXPECT_EQ(uniquelist::radix_key(std::uint64_t{7}), 7u);
+}
+
+TEST(TestUtilsUniqueList, TestRadixSort) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<std::int64_t> dist(-1000, 1000);
+  std::vector<std::int64_t> values(5000);
+  for (auto &x : values) {
+    x = dist(rng);
+  }
+  std::vector<std::uint64_t> keys;
+  for (auto x : values) {
+    keys.push_back(uniquelist::radix_key(x));
+  }
+  std::vector<size_t> order(values.size());
+  uniquelist::radix_sort(keys.size(), keys.data(), order.data());
+
+  // The sort is stable, as std::stable_sort.
+  std::vector<size_t> expected(values.size());
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(), [&](auto a, auto b) {
+    return values[a] < values[b];
+  });
+  EXPECT_EQ(order, expected);
+
+  std::uint32_t same[] = {5, 5, 5};
+  int trivial[3];
+  uniquelist::radix_sort(3, same, trivial);
+  EXPECT_EQ(std::vector<int>(trivial, trivial + 3),
+            (std::vector<int>{0, 1, 2}));
+  uniquelist::radix_sort(0, same, trivial);
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/bucketed_map.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithBucketedMap) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less,
+                         uniquelist::bucketed_map>
+      list;
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.9});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0, 4.9});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({1.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0, 4.8999999999});
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, uniquelist::deepcopy<std::shared_ptr<double[]>>);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    std::vector<double> x = {3.4, 1.0, 4.0};
+    auto [pos, isnew] = list.push_back_with_hook(
+        uniquelist::as_view(x.size(), x.data()), [](const auto &x) {
+          return uniquelist::copy_as<std::shared_ptr<double[]>>(x);
+        });
+    EXPECT_EQ(pos, 3);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  EXPECT_TRUE(list.isin(uniquelist::as_sized_ptr({1.0000000001})));
+  EXPECT_FALSE(list.isin(uniquelist::as_sized_ptr({2.9, -1.0, 4.8})));
+  EXPECT_FALSE(list.isin(uniquelist::as_sized_ptr({2.9, -1.0})));
+  EXPECT_EQ(std::size(list), 4);
+
+  {
+    std::vector<double> out;
+    for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+      out.push_back(it->ptr[it->size - 1]);
+    }
+    std::vector<double> expected = {1.0, 4.9, 4.0, 4.9};
+    EXPECT_EQ(out, expected);
+  }
+
+  list.erase(2);
+  EXPECT_FALSE(list.isin(uniquelist::as_sized_ptr({1.0})));
+  EXPECT_EQ(std::size(list), 3);
+}
+
+TEST(TestUtilsUniqueList, TestBucketedMapMatchesStdMap) {
+  // The sorted order, the positions and the erasure must agree with
+  // those of the default std::map for random arrays of mixed sizes.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using compare = uniquelist::strictly_less;
+  uniquelist::uniquelist<array, compare> expected{compare{1e-3, 1e-3}};
+  uniquelist::uniquelist<array, compare, uniquelist::bucketed_map> list{
+      compare{1e-3, 1e-3}};
+
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> size_dist(0, 12);
+  std::uniform_int_distribution<int> value_dist(-2, 2);
+  for (int i = 0; i < 2000; ++i) {
+    auto size = static_cast<size_t>(size_dist(gen));
+    std::shared_ptr<double[]> p{new double[size]};
+    for (size_t j = 0; j < size; ++j) {
+      p[j] = value_dist(gen) * 0.5;
+    }
+    array a{size, p};
+    EXPECT_EQ(list.push_back(a), expected.push_back(a));
+    if (i % 7 == 0 && list.size() > 0) {
+      auto index = static_cast<size_t>(i) % list.size();
+      list.erase(index);
+      expected.erase(index);
+    }
+  }
+
+  std::vector<array> sorted;
+  for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+    sorted.push_back(*it);
+  }
+  std::vector<array> expected_sorted;
+  for (auto it = expected.sbegin(), end = expected.send(); it != end; ++it) {
+    expected_sorted.push_back(*it);
+  }
+  ASSERT_EQ(sorted.size(), expected_sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    EXPECT_EQ(sorted[i].ptr, expected_sorted[i].ptr);
+  }
+
+  // Iterate backward.
+  {
+    auto it = list.send();
+    for (size_t i = sorted.size(); i > 0; --i) {
+      --it;
+      EXPECT_EQ(it->ptr, sorted[i - 1].ptr);
+    }
+    EXPECT_EQ(it, list.sbegin());
+  }
+}
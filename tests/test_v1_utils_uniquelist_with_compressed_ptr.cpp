@@ -0,0 +1,132 @@
+#include <cmath>
+#include <iostream>
+#include <iterator> // std::prev
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/compressed_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestXorEncodeIsLossless) {
+  std::vector<double> x = {0.0,
+                           -0.0,
+                           1.0,
+                           1.0,
+                           2.0,
+                           -3.5,
+                           1e-300,
+                           std::numeric_limits<double>::infinity(),
+                           std::numeric_limits<double>::quiet_NaN(),
+                           0.1,
+                           0.1,
+                           0.0};
+  auto encoded = uniquelist::detail::xor_encode(x.data(), x.size());
+  EXPECT_LT(encoded.size(), x.size() * sizeof(double));
+  uniquelist::detail::xor_decoder<double> decoder{encoded.data()};
+  for (auto v : x) {
+    auto y = decoder.next();
+    EXPECT_EQ(uniquelist::detail::to_bits(y), uniquelist::detail::to_bits(v));
+  }
+  EXPECT_EQ(decoder.pos, encoded.data() + encoded.size());
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithCompressedPtr) {
+  using array = uniquelist::compressed_ptr<double>;
+  uniquelist::cold_storage<double> storage{4};
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+  auto copy = [&](const array &x) { return storage.copy(x); };
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(-3, 3);
+  std::vector<std::vector<double>> inputs;
+  for (int i = 0; i < 200; ++i) {
+    std::vector<double> x(20);
+    for (auto &v : x) {
+      v = dist(gen) * 0.5;
+    }
+    inputs.push_back(x);
+  }
+
+  std::vector<size_t> positions;
+  for (auto &x : inputs) {
+    auto [pos, isnew] =
+        list.push_back_with_hook(storage.view(x.data(), x.size()), copy);
+    EXPECT_EQ(isnew, pos == list.size() - 1);
+    positions.push_back(pos);
+    storage.tick();
+  }
+  EXPECT_EQ(list.size(), 200);
+
+  // Keys not used for a while are compressed and take less memory.
+  for (int i = 0; i < 10; ++i) {
+    storage.tick();
+  }
+  storage.compress_unused();
+  EXPECT_EQ(storage.compressed_count(), list.size());
+  EXPECT_EQ(storage.dense_bytes(), 0);
+  EXPECT_LT(storage.compressed_bytes() * 2,
+            list.size() * 20 * sizeof(double));
+
+  // Compressed keys are decoded for the comparison and the iteration.
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto &x = inputs[i];
+    auto [pos, isnew] =
+        list.push_back_with_hook(storage.view(x.data(), x.size()), copy);
+    EXPECT_EQ(pos, positions[i]);
+    EXPECT_FALSE(isnew);
+  }
+  {
+    size_t i = 0;
+    for (auto it = list.begin(), end = list.end(); it != end; ++it, ++i) {
+      EXPECT_TRUE(it->compressed());
+      EXPECT_EQ(it->decode(), inputs[i]);
+    }
+  }
+
+  // A key within the tolerance is found.
+  {
+    auto x = inputs[3];
+    x[19] += 1e-9;
+    EXPECT_TRUE(list.isin(storage.view(x.data(), x.size())));
+    x[19] += 1e-3;
+    EXPECT_FALSE(list.isin(storage.view(x.data(), x.size())));
+  }
+
+  // New keys are kept uncompressed until they become cold.
+  {
+    std::vector<double> x = {1.0, 2.0};
+    auto [pos, isnew] =
+        list.push_back_with_hook(storage.view(x.data(), x.size()), copy);
+    EXPECT_EQ(pos, 200);
+    EXPECT_TRUE(isnew);
+    EXPECT_FALSE(std::prev(list.end())->compressed());
+  }
+
+  list.clear();
+  EXPECT_EQ(storage.compressed_count(), 0);
+  EXPECT_EQ(storage.compressed_bytes(), 0);
+  EXPECT_EQ(storage.dense_bytes(), 0);
+}
+
+TEST(TestUtilsUniqueList, TestColdStorageKeepsUsedKeys) {
+  using array = uniquelist::compressed_ptr<double>;
+  uniquelist::cold_storage<double> storage{8, 1};
+  std::vector<double> hot = {1.0, 2.0, 3.0, 4.0};
+  std::vector<double> cold = {1.0, 2.0, 3.0, 5.0};
+  array a = storage.copy(hot.data(), hot.size());
+  array b = storage.copy(cold.data(), cold.size());
+  auto probe = storage.view(hot.data(), hot.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(a < probe);
+    storage.tick();
+  }
+  EXPECT_FALSE(a.compressed());
+  EXPECT_TRUE(b.compressed());
+  EXPECT_TRUE(a < b);
+  EXPECT_FALSE(b < a);
+  EXPECT_EQ(b.decode(), cold);
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <iterator> // std::back_inserter
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/fixed_array.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestFixedArrayCompare) {
+  using array = uniquelist::fixed_array<double, 3>;
+
+  static_assert(array{{1.0, 2.0, 3.0}} < array{{1.0, 2.0, 4.0}});
+  static_assert(!(array{{1.0, 2.0, 3.0}} < array{{1.0, 2.0, 3.0}}));
+  static_assert(uniquelist::strictly_less{}(array{{1.0, 2.0, 3.0}},
+                                            array{{1.0, 2.5, 0.0}}));
+
+  uniquelist::strictly_less less;
+  EXPECT_FALSE(less(array{{1.0, 2.0, 3.0}}, array{{1.0, 2.0, 3.0000000001}}));
+  EXPECT_FALSE(less(array{{1.0, 2.0, 3.0000000001}}, array{{1.0, 2.0, 3.0}}));
+  EXPECT_TRUE(less(array{{1.0, 2.0, 3.0}}, array{{1.0, 2.0, 3.1}}));
+
+  using long_array = uniquelist::fixed_array<double, 40>;
+  long_array a{};
+  long_array b{};
+  b[39] = 1.0;
+  EXPECT_TRUE(a < b);
+  EXPECT_FALSE(b < a);
+  EXPECT_TRUE(less(a, b));
+  EXPECT_FALSE(less(b, a));
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithFixedArray) {
+  using array = uniquelist::fixed_array<double, 3>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+
+  {
+    auto [pos, isnew] = list.push_back({{2.9, -1.0, 4.9}});
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    double buf[] = {3.4, 1.0, 4.9};
+    auto [pos, isnew] = list.push_back(uniquelist::as_fixed_array<3>(buf));
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back({{3.4, 1.0, 4.8999999999}});
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back({{-5.0, 0.0, 0.0}});
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  EXPECT_TRUE(list.isin({{2.9, -1.0, 4.9}}));
+  EXPECT_FALSE(list.isin({{2.9, -1.0, 4.8}}));
+  EXPECT_EQ(std::size(list), 3);
+
+  {
+    std::vector<double> out;
+    for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+      out.push_back((*it)[0]);
+    }
+    std::vector<double> expected = {-5.0, 2.9, 3.4};
+    EXPECT_EQ(out, expected);
+  }
+
+  std::vector<int> flags = {true, false, false};
+  list.erase_nonzero(std::size(flags), flags.data());
+
+  EXPECT_EQ(std::size(list), 2);
+  EXPECT_FALSE(list.isin({{2.9, -1.0, 4.9}}));
+}
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <iterator> // std::back_inserter
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/grid_map.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithGridMap) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less, uniquelist::grid_map>
+      list;
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.9});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0, 4.9});
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, uniquelist::deepcopy<std::shared_ptr<double[]>>);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0, 4.8999999999});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.9000000001});
+    EXPECT_TRUE(list.isin(a));
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.8});
+    EXPECT_FALSE(list.isin(a));
+  }
+
+  EXPECT_EQ(std::size(list), 3);
+
+  std::vector<int> flags = {false, true, false};
+  list.erase_nonzero(std::size(flags), flags.data());
+
+  EXPECT_EQ(std::size(list), 2);
+
+  {
+    auto a = uniquelist::as_sized_ptr({3.4, 1.0, 4.9});
+    EXPECT_FALSE(list.isin(a));
+  }
+}
+
+TEST(TestUtilsUniqueList, TestGridMapCellBoundary) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::strictly_less less{0.0, 1e-3};
+  uniquelist::grid_map<array, int> map{less, {4.0, 8}};
+
+  // With rtol = 0, cells have width 4 * atol (up to a small margin)
+  // and the boundaries are close to multiples of 4e-3.  Values on both
+  // sides of a boundary must be found.
+  for (double x : {0.0, 4e-3, -4e-3, 1.0, 12e-3}) {
+    map.clear();
+    auto a = uniquelist::as_sized_ptr({x - 4e-4, 0.5});
+    auto b = uniquelist::as_sized_ptr({x + 4e-4, 0.5});
+    auto c = uniquelist::as_sized_ptr({x + 2.1e-3, 0.5});
+    EXPECT_TRUE(map.try_emplace(a, 0).second);
+    EXPECT_EQ(map.count(b), 1);
+    EXPECT_EQ(map.count(c), 0);
+    EXPECT_FALSE(map.try_emplace(b, 1).second);
+    EXPECT_TRUE(map.try_emplace(c, 2).second);
+    EXPECT_EQ(map.size(), 2);
+  }
+}
+
+TEST(TestUtilsUniqueList, TestGridMapFirstMatch) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::strictly_less less{0.0, 1.0};
+  uniquelist::grid_map<array, int> map{less};
+
+  // a and c are not equal but b is equal to both of them.
+  auto a = uniquelist::as_sized_ptr({0.0});
+  auto b = uniquelist::as_sized_ptr({0.9});
+  auto c = uniquelist::as_sized_ptr({1.8});
+  map.try_emplace(c, 0);
+  map.try_emplace(a, 1);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.find(b)->second, 0);
+  map.erase(map.find(c));
+  EXPECT_EQ(map.find(b)->second, 1);
+}
+
+TEST(TestUtilsUniqueList, TestGridMapEmplaceHint) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::strictly_less less{0.0, 1e-3};
+  uniquelist::grid_map<array, int> map{less, {4.0, 8}};
+
+  // The hint end() after a failed find adds the key to its cell
+  // without searching again.  Another hint searches as try_emplace.
+  auto a = uniquelist::as_sized_ptr({4e-3 - 4e-4, 0.5});
+  auto b = uniquelist::as_sized_ptr({4e-3 + 4e-4, 0.5});
+  ASSERT_EQ(map.find(a), map.end());
+  auto it = map.emplace_hint(map.end(), a, 0);
+  EXPECT_EQ(map.find(b), it);
+  EXPECT_EQ(map.emplace_hint(it, b, 1), it);
+  EXPECT_EQ(map.size(), 1);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithGridMapAssignSorted) {
+  // A list is restored from its elements in the order of insertion,
+  // which is the order of the map.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using list_type =
+      uniquelist::uniquelist<array, uniquelist::strictly_less,
+                             uniquelist::grid_map>;
+  list_type list{uniquelist::strictly_less{0.0, 1.0},
+                 uniquelist::grid_options{4.0, 2}};
+  for (double x : {5.0, 0.0, 1.8, 3.0}) {
+    list.push_back(uniquelist::as_sized_ptr({x}));
+  }
+  list.erase(0);
+  EXPECT_TRUE(list.strictly_sorted());
+
+  auto options = list.get_map().grid_options();
+  EXPECT_EQ(options.cell_width, 4.0);
+  EXPECT_EQ(options.hashed_size, 2);
+  std::vector<array> keys(list.sbegin(), list.send());
+  auto positions = list.sorted_positions();
+  list_type restored{list.key_comp(), options};
+  auto removed = restored.assign_sorted(
+      keys.size(), [&](size_t i) { return keys[i]; }, positions.data());
+  EXPECT_EQ(removed, 0);
+  ASSERT_EQ(restored.size(), 3);
+  for (size_t i = 0; i < restored.size(); ++i) {
+    EXPECT_EQ(restored.at(i).ptr[0], list.at(i).ptr[0]);
+  }
+  // 0.9 is equal to 0.0 and 1.8, and 0.0 is stored first.
+  EXPECT_EQ(restored.index(uniquelist::as_sized_ptr({0.9})), 0);
+}
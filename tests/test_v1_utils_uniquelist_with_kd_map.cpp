@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iterator> // std::back_inserter
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/kd_map.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithKdMap) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using distance = uniquelist::within_distance;
+  uniquelist::uniquelist<array, distance, uniquelist::kd_map> list{
+      distance{0.1, distance::l2}};
+
+  {
+    auto a = uniquelist::as_sized_ptr({0.0, 0.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({0.08, 0.08});
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, uniquelist::deepcopy<std::shared_ptr<double[]>>);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({0.06, 0.06});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({0.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  EXPECT_TRUE(list.isin(uniquelist::as_sized_ptr({0.09, 0.1})));
+  EXPECT_FALSE(list.isin(uniquelist::as_sized_ptr({0.2, 0.2})));
+  EXPECT_EQ(std::size(list), 3);
+
+  std::vector<int> flags = {true, false, false};
+  list.erase_nonzero(std::size(flags), flags.data());
+
+  EXPECT_EQ(std::size(list), 2);
+
+  {
+    auto a = uniquelist::as_sized_ptr({0.06, 0.06});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({-0.03, -0.03});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+}
+
+TEST(TestUtilsUniqueList, TestKdMapInsertErase) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using distance = uniquelist::within_distance;
+  uniquelist::kd_map<array, int> map{distance{0.5, distance::linf}};
+
+  // Keys are added in the sorted order so that the tree is rebuilt.
+  std::vector<array> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(uniquelist::as_sized_ptr({1.0 * i, -1.0 * i, 0.0}));
+    EXPECT_TRUE(map.try_emplace(keys.back(), i).second);
+  }
+  EXPECT_EQ(map.size(), 1000);
+
+  for (int i = 0; i < 1000; ++i) {
+    auto it = map.find(uniquelist::as_sized_ptr({i + 0.4, -i - 0.4, 0.4}));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->second, i);
+  }
+  EXPECT_EQ(map.count(uniquelist::as_sized_ptr({0.4, -0.4, 0.6})), 0);
+
+  // Remove every other key.
+  for (auto it = map.begin(); it != map.end();) {
+    it = map.erase(it);
+    ++it;
+  }
+  EXPECT_EQ(map.size(), 500);
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(map.count(keys[i]), i % 2);
+  }
+}
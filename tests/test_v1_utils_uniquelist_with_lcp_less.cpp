@@ -0,0 +1,88 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/lcp_less.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithLcpLess) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::lcp_less> list;
+  auto copy = [](const auto &x) { return uniquelist::deepcopy(x.key); };
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.0, 1.0, 4.0});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_lcp_probe(a), copy);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.0, 1.0, 3.0});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_lcp_probe(a), copy);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.0, 1.0, 4.0});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_lcp_probe(a), copy);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back(uniquelist::as_sized_ptr({2.0}));
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  auto probe = [](std::initializer_list<double> &&l) {
+    return uniquelist::as_lcp_probe(uniquelist::as_sized_ptr(std::move(l)));
+  };
+  EXPECT_TRUE(list.isin(probe({2.0, 1.0, 3.0})));
+  EXPECT_TRUE(list.isin(probe({2.0})));
+  EXPECT_FALSE(list.isin(probe({2.0, 1.0, 3.5})));
+  EXPECT_FALSE(list.isin(probe({2.0, 1.0})));
+  EXPECT_EQ(std::size(list), 3);
+}
+
+TEST(TestUtilsUniqueList, TestLcpLessMatchesStdLess) {
+  // Arrays share a long prefix and differ in a few trailing elements.
+  // The positions must agree with the default comparison while the
+  // number of elements read per comparison stays small.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  const size_t d = 200;
+  auto stats = std::make_shared<uniquelist::depth_stats>();
+  uniquelist::uniquelist<array, uniquelist::lcp_less> list{
+      uniquelist::lcp_less{stats}};
+  uniquelist::uniquelist<array, std::less<array>> expected;
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> dist(0, 3);
+  std::uniform_int_distribution<size_t> split(d - 8, d - 1);
+  for (int trial = 0; trial < 2000; ++trial) {
+    std::shared_ptr<double[]> p{new double[d]};
+    auto s = split(engine);
+    for (size_t i = 0; i < d; ++i) {
+      p[i] = (i < s) ? 1.0 : dist(engine);
+    }
+    array a{d, p};
+    auto result = list.push_back_with_hook(
+        uniquelist::as_lcp_probe(a),
+        [](const auto &x) { return uniquelist::deepcopy(x.key); });
+    EXPECT_EQ(result, expected.push_back(uniquelist::deepcopy(a)));
+    EXPECT_EQ(list.isin(uniquelist::as_lcp_probe(a)), true);
+    p[0] = 2.0;
+    EXPECT_EQ(list.isin(uniquelist::as_lcp_probe(a)), false);
+  }
+  EXPECT_EQ(std::size(list), std::size(expected));
+  EXPECT_LT(stats->depth(), d / 4.0);
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/permuted_less.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithPermutedLess) {
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using compare = uniquelist::permuted_less<>;
+  auto order = std::make_shared<const std::vector<size_t>>(
+      std::vector<size_t>{2, 0, 1});
+  uniquelist::uniquelist<array, compare> list{compare{{}, order}};
+
+  list.push_back(uniquelist::as_sized_ptr({1.0, 1.0, 3.0}));
+  list.push_back(uniquelist::as_sized_ptr({2.0, 1.0, 2.0}));
+  list.push_back(uniquelist::as_sized_ptr({1.0, 2.0}));
+
+  {
+    auto [pos, isnew] =
+        list.push_back(uniquelist::as_sized_ptr({2.0, 1.0, 2.0000000001}));
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    // The last coordinate is compared first.
+    std::vector<double> out;
+    for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+      out.push_back(it->ptr[0]);
+    }
+    std::vector<double> expected = {1.0, 2.0, 1.0};
+    EXPECT_EQ(out, expected);
+  }
+
+  EXPECT_TRUE(list.isin(uniquelist::as_sized_ptr({1.0, 1.0, 3.0})));
+  EXPECT_FALSE(list.isin(uniquelist::as_sized_ptr({1.0, 1.0, 2.0})));
+}
+
+TEST(TestUtilsUniqueList, TestPermutedLessAdaptsOrder) {
+  // The first coordinates are constant and only the last ones vary.
+  // After adapting the order, the positions must be kept while the
+  // comparisons read fewer elements.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  using compare = uniquelist::permuted_less<>;
+  const size_t d = 50;
+  auto stats = std::make_shared<uniquelist::depth_stats>();
+  uniquelist::uniquelist<array, compare> list{compare{{}, {}, stats}};
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> dist(0, 9);
+  std::vector<array> arrays;
+  for (int i = 0; i < 3000; ++i) {
+    std::shared_ptr<double[]> p{new double[d]};
+    for (size_t j = 0; j < d; ++j) {
+      p[j] = (j < d - 4) ? 1.0 : dist(engine);
+    }
+    arrays.push_back(array{d, p});
+  }
+
+  std::vector<std::pair<size_t, bool>> before;
+  for (size_t i = 0; i < 1000; ++i) {
+    before.push_back(list.push_back(arrays[i]));
+  }
+  auto depth_before = stats->depth();
+
+  EXPECT_TRUE(uniquelist::adapt_order(list));
+  EXPECT_FALSE(uniquelist::adapt_order(list));
+  EXPECT_GE(list.key_comp().order->front(), d - 4);
+  EXPECT_EQ(list.key_comp().stats, stats);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(list.isin(arrays[i]));
+    EXPECT_EQ(list.push_back(arrays[i]).first, before[i].first);
+  }
+  stats->reset();
+  uniquelist::uniquelist<array, std::less<array>> expected;
+  for (size_t i = 0; i < 1000; ++i) {
+    expected.push_back(arrays[i]);
+  }
+  for (size_t i = 1000; i < arrays.size(); ++i) {
+    EXPECT_EQ(list.push_back(arrays[i]), expected.push_back(arrays[i]));
+  }
+  EXPECT_LT(stats->depth(), depth_before / 4);
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iterator> // std::back_inserter
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/prefixed_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithPrefixedPtr) {
+  using array = uniquelist::prefixed_ptr<std::shared_ptr<double[]>>;
+  using compare = uniquelist::prefix_less<>;
+  auto stats = std::make_shared<uniquelist::prefix_stats>();
+  uniquelist::uniquelist<array, compare> list{compare{{}, stats}};
+
+  {
+    auto a =
+        uniquelist::with_prefix(uniquelist::as_sized_ptr({2.9, -1.0, 4.9}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_prefix(uniquelist::as_sized_ptr({3.4, 1.0, 4.9}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_prefix(uniquelist::as_sized_ptr({1.0}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_prefix(
+        uniquelist::as_sized_ptr({3.4, 1.0, 4.8999999999}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::with_prefix(uniquelist::as_sized_ptr({3.4, 1.0, 4.0}));
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, [](const array &x) { return uniquelist::deepcopy(x); });
+    EXPECT_EQ(pos, 3);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_prefix(uniquelist::as_sized_ptr({1.0000000001}));
+    EXPECT_TRUE(list.isin(a));
+  }
+
+  {
+    auto a =
+        uniquelist::with_prefix(uniquelist::as_sized_ptr({2.9, -1.0, 4.8}));
+    EXPECT_FALSE(list.isin(a));
+  }
+
+  EXPECT_EQ(std::size(list), 4);
+  EXPECT_GT(stats->comparisons, 0);
+  EXPECT_GT(stats->resolved, 0);
+  EXPECT_LT(stats->resolved, stats->comparisons);
+  EXPECT_EQ(stats->hit_rate(),
+            static_cast<double>(stats->resolved) / stats->comparisons);
+
+  stats->reset();
+  EXPECT_EQ(stats->comparisons, 0);
+
+  {
+    std::vector<double> out;
+    for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+      out.push_back(it->ptr[it->size - 1]);
+    }
+    std::vector<double> expected = {1.0, 4.9, 4.0, 4.9};
+    EXPECT_EQ(out, expected);
+  }
+}
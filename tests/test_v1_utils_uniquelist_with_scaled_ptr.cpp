@@ -0,0 +1,108 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/scaled_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestComputeScale) {
+  std::vector<double> x = {0.0, -2.0, 4.0, -8.0};
+  EXPECT_EQ(uniquelist::compute_scale(x.data(), x.size()), 8.0);
+  EXPECT_EQ(uniquelist::compute_scale(x.data(), x.size(),
+                                      uniquelist::scaling::first_nonzero),
+            2.0);
+  std::vector<double> zero = {0.0, 0.0};
+  EXPECT_EQ(uniquelist::compute_scale(zero.data(), zero.size()), 1.0);
+  EXPECT_EQ(uniquelist::compute_scale(zero.data(), 0), 1.0);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithScaledPtr) {
+  using array = uniquelist::scaled_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+
+  {
+    auto a = uniquelist::with_scale(uniquelist::as_sized_ptr({1.0, -2.0, 3.0}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_scale(uniquelist::as_sized_ptr({0.3, -0.6, 0.9}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    // A negative factor gives a different constraint.
+    auto a =
+        uniquelist::with_scale(uniquelist::as_sized_ptr({-1.0, 2.0, -3.0}));
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_scale(uniquelist::as_sized_ptr({0.0, 0.0}));
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, [](const array &x) { return uniquelist::deepcopy(x); });
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::with_scale(
+        uniquelist::as_sized_ptr({10.0, -20.0, 30.0000001}));
+    EXPECT_TRUE(list.isin(a));
+  }
+
+  {
+    auto a =
+        uniquelist::with_scale(uniquelist::as_sized_ptr({10.0, -20.0, 31.0}));
+    EXPECT_FALSE(list.isin(a));
+  }
+
+  EXPECT_EQ(std::size(list), 3);
+
+  // The original arrays and the factors are kept.
+  {
+    auto it = list.begin();
+    EXPECT_EQ(it->scale, 3.0);
+    EXPECT_EQ(it->ptr[1], -2.0);
+  }
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithScaledPtrFirstNonzero) {
+  using array = uniquelist::scaled_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, std::less<array>> list;
+  auto mode = uniquelist::scaling::first_nonzero;
+
+  {
+    auto a = uniquelist::with_scale(
+        uniquelist::as_sized_ptr({0.0, -2.0, 3.0}), mode);
+    EXPECT_EQ(a.scale, 2.0);
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    // Scaling by a power of 2 is exact.
+    auto a = uniquelist::with_scale(
+        uniquelist::as_sized_ptr({0.0, -8.0, 12.0}), mode);
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::with_scale(
+        uniquelist::as_sized_ptr({0.0, 2.0, -3.0}), mode);
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/set_key.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestCanonicalize) {
+  // By the 0-1 principle, a network sorts any input if it sorts
+  // all inputs of zeros and ones.
+  for (size_t n = 2; n <= 8; ++n) {
+    for (unsigned bits = 0; bits < (1u << n); ++bits) {
+      std::vector<int> x(n);
+      for (size_t i = 0; i < n; ++i) {
+        x[i] = (bits >> i) & 1;
+      }
+      auto expected = x;
+      std::sort(expected.begin(), expected.end());
+      expected.erase(std::unique(expected.begin(), expected.end()),
+                     expected.end());
+      auto m = uniquelist::canonicalize(x.data(), n);
+      x.resize(m);
+      EXPECT_EQ(x, expected);
+    }
+  }
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<std::int64_t> dist(-20, 20);
+  for (size_t n = 0; n < 40; ++n) {
+    std::vector<std::int64_t> x(n);
+    for (auto &v : x) {
+      v = dist(gen);
+    }
+    auto expected = x;
+    std::sort(expected.begin(), expected.end());
+    expected.erase(std::unique(expected.begin(), expected.end()),
+                   expected.end());
+    x.resize(uniquelist::canonicalize(x.data(), n));
+    EXPECT_EQ(x, expected);
+  }
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithSetKey) {
+  using key = uniquelist::set_key<std::shared_ptr<int[]>>;
+  uniquelist::uniquelist<key> list;
+
+  {
+    auto [pos, isnew] = list.push_back(uniquelist::as_set_key({3, 1, 2}));
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back(uniquelist::as_set_key({2, 3, 1, 3}));
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back(uniquelist::as_set_key({1, 2}));
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto [pos, isnew] = list.push_back(uniquelist::as_set_key<int>({}));
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    std::vector<int> x = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 10};
+    auto n = uniquelist::canonicalize(x.data(), x.size());
+    auto view =
+        uniquelist::as_set_key(n, uniquelist::shared_ptr_without_ownership(
+                                      x.data()));
+    auto [pos, isnew] = list.push_back_with_hook(
+        view, [](const key &k) { return uniquelist::deepcopy(k); });
+    EXPECT_EQ(pos, 3);
+    EXPECT_EQ(isnew, 1);
+    EXPECT_NE(list.begin()->ptr.get(), x.data());
+  }
+
+  EXPECT_TRUE(list.isin(uniquelist::as_set_key({1, 2, 3})));
+  EXPECT_TRUE(
+      list.isin(uniquelist::as_set_key({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10})));
+  EXPECT_FALSE(list.isin(uniquelist::as_set_key({1, 3})));
+  EXPECT_EQ(std::size(list), 4);
+
+  // With strictly_less the integers are compared exactly.
+  uniquelist::uniquelist<key, uniquelist::strictly_less> tolerant;
+  tolerant.push_back(uniquelist::as_set_key({1, 2}));
+  EXPECT_TRUE(tolerant.isin(uniquelist::as_set_key({2, 1})));
+  EXPECT_FALSE(tolerant.isin(uniquelist::as_set_key({1, 3})));
+}
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/shadowed_ptr.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithShadowedPtr) {
+  using array = uniquelist::shadowed_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+  auto copy = [](const auto &x) { return uniquelist::deepcopy(x); };
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.9});
+    auto [pos, isnew] = list.push_back(uniquelist::with_shadow(a));
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.8999999999});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::without_shadow(a), copy);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    // Differs by less than the precision of float but more than
+    // the tolerance.
+    auto a = uniquelist::as_sized_ptr({2.9, -1.0, 4.90001});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::without_shadow(a), copy);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+    EXPECT_TRUE(list.isin(uniquelist::with_shadow(a)));
+  }
+
+  {
+    auto a = uniquelist::as_sized_ptr({1e300, 0.0});
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::without_shadow(a), copy);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+    auto b = uniquelist::as_sized_ptr({1.1e300, 0.0});
+    EXPECT_FALSE(list.isin(uniquelist::with_shadow(b)));
+  }
+
+  EXPECT_EQ(std::size(list), 3);
+}
+
+TEST(TestUtilsUniqueList, TestShadowedPtrMatchesStrictlyLess) {
+  // Pairs of arrays differ around the boundary of the tolerance, where
+  // the shadows cannot decide the order.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<double> value(-10.0, 10.0);
+  std::uniform_real_distribution<double> factor(0.5, 1.5);
+  std::uniform_int_distribution<int> kind(0, 3);
+  const size_t d = 8;
+  for (double tol : {0.0, 1e-9, 1e-6, 1e-3}) {
+    uniquelist::strictly_less less{tol, tol};
+    for (int trial = 0; trial < 20000; ++trial) {
+      std::shared_ptr<double[]> p{new double[d]};
+      std::shared_ptr<double[]> q{new double[d]};
+      for (size_t i = 0; i < d; ++i) {
+        p[i] = value(engine);
+        switch (kind(engine)) {
+        case 0:
+          q[i] = p[i];
+          break;
+        case 1:
+          q[i] = p[i] + (std::abs(p[i]) * tol + tol) * factor(engine);
+          break;
+        case 2:
+          q[i] = p[i] - (std::abs(p[i]) * tol + tol) * factor(engine);
+          break;
+        default:
+          q[i] = value(engine);
+        }
+      }
+      array a{d, p};
+      array b{d, q};
+      auto sa = uniquelist::with_shadow(a);
+      auto sb = uniquelist::with_shadow(b);
+      EXPECT_EQ(less(sa, sb), less(a, b));
+      EXPECT_EQ(less(sb, sa), less(b, a));
+      EXPECT_EQ(less(uniquelist::without_shadow(a), sb), less(a, b));
+    }
+  }
+}
+
+TEST(TestUtilsUniqueList, TestShadowedPtrTinyElements) {
+  // Tiny elements are rounded to the same float but are not equal
+  // without an absolute tolerance.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  std::shared_ptr<double[]> p{new double[2]{0.0, 1.0}};
+  std::shared_ptr<double[]> q{new double[2]{1e-46, 1.0}};
+  array a{2, p};
+  array b{2, q};
+  auto sa = uniquelist::with_shadow(a);
+  auto sb = uniquelist::with_shadow(b);
+  for (double atol : {0.0, 1e-50, 1e-40}) {
+    uniquelist::strictly_less less{1e-3, atol};
+    EXPECT_EQ(less(sa, sb), less(a, b));
+    EXPECT_EQ(less(sb, sa), less(b, a));
+  }
+  EXPECT_TRUE(uniquelist::strictly_less(1e-3, 0.0)(a, b));
+}
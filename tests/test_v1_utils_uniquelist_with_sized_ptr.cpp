@@ -86,3 +86,76 @@ TEST(TestUtilsUniqueList, TestUniquelistWithSizedPtr) {
     EXPECT_EQ(std::size(list), 3);
   }
 }
+
+TEST(TestUtilsUniqueList, TestUniquelistWithSizedPtrIndexMany) {
+  // Keys equal to the arrays within the tolerance are found in a merge.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list{
+      uniquelist::strictly_less{0, 1e-3}};
+  std::vector<double> data;
+  for (int i = 0; i < 50; ++i) {
+    data.push_back(i % 7);
+    data.push_back(i);
+  }
+  for (int i = 0; i < 50; ++i) {
+    list.push_back(uniquelist::as_sized_ptr({data[2 * i], data[2 * i + 1]}));
+  }
+  std::vector<double> queries;
+  for (int i = 0; i < 200; ++i) {
+    queries.push_back(i % 7 + ((i % 3 == 0) ? 1e-4 : 0.0));
+    queries.push_back(i * 0.5);
+  }
+  auto key = [&](size_t i) {
+    return uniquelist::as_view(2, queries.data() + 2 * i);
+  };
+  std::vector<size_t> positions(200);
+  list.index_many(200, key, positions.data());
+  for (size_t i = 0; i < 200; ++i) {
+    EXPECT_EQ(positions[i], list.index(key(i)));
+  }
+  EXPECT_EQ(positions[14], 7);
+  EXPECT_EQ(positions[42], 21); // Equal within the tolerance.
+  EXPECT_EQ(positions[1], list.size());
+
+  // Keys spread wider than the tolerance are not all equal to the
+  // element preceding them in a merge.
+  uniquelist::uniquelist<array, uniquelist::strictly_less> wide{
+      uniquelist::strictly_less{0, 1}};
+  wide.push_back(uniquelist::as_sized_ptr({1.0}));
+  std::vector<double> spread = {0.1, -0.5};
+  auto spread_key = [&](size_t i) {
+    return uniquelist::as_view(1, spread.data() + i);
+  };
+  bool found[2];
+  wide.isin_many(2, spread_key, found);
+  EXPECT_TRUE(found[0]);
+  EXPECT_FALSE(found[1]);
+  EXPECT_FALSE(wide.isin(spread_key(1)));
+  wide.index_many(2, spread_key, positions.data());
+  EXPECT_EQ(positions[0], 0);
+  EXPECT_EQ(positions[1], wide.size());
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithSizedPtrAssignSorted) {
+  // {0, 0} and {1, 0} are equal within the tolerance but are accepted
+  // since {1, 0} is compared only with {2, -5}, the root of the map.
+  using array = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list{
+      uniquelist::strictly_less{0, 1}};
+  list.push_back(uniquelist::as_sized_ptr({2.0, -5.0}));
+  list.push_back(uniquelist::as_sized_ptr({0.0, 0.0}));
+  EXPECT_TRUE(list.push_back(uniquelist::as_sized_ptr({1.0, 0.0})).second);
+  EXPECT_TRUE(list.strictly_sorted());
+  list.erase(0);
+  EXPECT_FALSE(list.strictly_sorted());
+
+  // Restoring the list loses one of them.
+  std::vector<array> keys(list.sbegin(), list.send());
+  auto positions = list.sorted_positions();
+  uniquelist::uniquelist<array, uniquelist::strictly_less> restored{
+      uniquelist::strictly_less{0, 1}};
+  auto removed = restored.assign_sorted(
+      keys.size(), [&](size_t i) { return keys[i]; }, positions.data());
+  EXPECT_EQ(removed, 1);
+  EXPECT_TRUE(restored.strictly_sorted());
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <iterator> // std::back_inserter
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/sparse_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestSparsePtrCompare) {
+  // Compare random sparse arrays with the corresponding dense arrays.
+  std::mt19937 generator{0};
+  std::uniform_int_distribution<int> coin{0, 2};
+  using sparse = uniquelist::sparse_ptr<std::shared_ptr<double[]>,
+                                        std::shared_ptr<int[]>>;
+  using dense = uniquelist::sized_ptr<std::shared_ptr<double[]>>;
+  auto random_array = [&](size_t size) {
+    dense d{size, std::shared_ptr<double[]>{new double[size]}};
+    sparse s{size, 0, std::shared_ptr<int[]>{new int[size]},
+             std::shared_ptr<double[]>{new double[size]}};
+    for (size_t i = 0; i < size; ++i) {
+      // Some zeros are stored explicitly.
+      auto x = coin(generator);
+      auto v = (coin(generator) == 0) ? 0.0 : 1e-7 * coin(generator);
+      d.ptr[i] = (x == 0) ? 0.0 : v;
+      if (x > 0) {
+        s.index[s.nnz] = static_cast<int>(i);
+        s.value[s.nnz] = v;
+        ++s.nnz;
+      }
+    }
+    return std::make_pair(d, s);
+  };
+  uniquelist::strictly_less tolerant{0.0, 1.5e-7};
+  for (int trial = 0; trial < 1000; ++trial) {
+    auto [da, sa] = random_array(2 + trial % 2);
+    auto [db, sb] = random_array(2 + (trial / 2) % 2);
+    EXPECT_EQ(sa < sb, da < db);
+    EXPECT_EQ(tolerant(sa, sb), tolerant(da, db));
+    auto ca = uniquelist::deepcopy(sa);
+    EXPECT_EQ(tolerant(ca, sb), tolerant(da, db));
+  }
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithSparsePtr) {
+  using array = uniquelist::sparse_ptr<std::shared_ptr<double[]>,
+                                       std::shared_ptr<int[]>>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+
+  {
+    auto a = uniquelist::as_sparse_ptr(1000, {3, 500}, {1.0, 2.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sparse_ptr(1000, {3, 499, 500}, {1.0, 0.0, 2.0});
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, uniquelist::deepcopy<std::shared_ptr<double[]>,
+                                std::shared_ptr<int[]>>);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    auto a = uniquelist::as_sparse_ptr(1000, {3, 499}, {1.0, 2.0});
+    auto [pos, isnew] = list.push_back_with_hook(
+        a, uniquelist::deepcopy<std::shared_ptr<double[]>,
+                                std::shared_ptr<int[]>>);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    auto a = uniquelist::as_sparse_ptr(999, {3, 499}, {1.0, 2.0});
+    auto [pos, isnew] = list.push_back(a);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  EXPECT_TRUE(list.isin(uniquelist::as_sparse_ptr(1000, {3, 500},
+                                                  {1.0000000001, 2.0})));
+  EXPECT_FALSE(list.isin(uniquelist::as_sparse_ptr(1000, {3}, {1.0})));
+  EXPECT_EQ(std::size(list), 3);
+
+  EXPECT_THROW(uniquelist::as_sparse_ptr(10, {3, 2}, {1.0, 2.0}),
+               std::invalid_argument);
+  EXPECT_THROW(uniquelist::as_sparse_ptr(10, {3, 10}, {1.0, 2.0}),
+               std::invalid_argument);
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uniquelist/grid_map.h"
+#include "uniquelist/sized_ptr.h"
+#include "uniquelist/uniquelist.h"
+
+TEST(TestUtilsUniqueList, TestUniquelistWithUniquePtr) {
+  // Keys owned by unique_ptr cannot be copied, so that this only
+  // compiles if the list moves keys and searches by views.
+  using pointer = std::unique_ptr<double[]>;
+  using array = uniquelist::sized_ptr<pointer>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less> list;
+  auto copy = [](const auto &x) { return uniquelist::copy_as<pointer>(x); };
+
+  {
+    std::vector<double> x = {2.9, -1.0, 4.9};
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_view(x.size(), x.data()), copy);
+    EXPECT_EQ(pos, 0);
+    EXPECT_EQ(isnew, 1);
+    EXPECT_NE(list.begin()->ptr.get(), x.data());
+  }
+
+  {
+    std::vector<double> x = {3.4, 1.0, 4.9};
+    auto [pos, isnew] =
+        list.push_back(uniquelist::copy_as<pointer>(
+            uniquelist::as_view(x.size(), x.data())));
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    std::vector<double> x = {3.4, 1.0, 4.8999999999};
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_view(x.size(), x.data()), copy);
+    EXPECT_EQ(pos, 1);
+    EXPECT_EQ(isnew, 0);
+  }
+
+  {
+    const std::vector<double> x = {1.0};
+    auto [pos, isnew] =
+        list.push_back_with_hook(uniquelist::as_view(x.size(), x.data()), copy);
+    EXPECT_EQ(pos, 2);
+    EXPECT_EQ(isnew, 1);
+  }
+
+  {
+    std::vector<double> x = {1.0000000001};
+    EXPECT_TRUE(list.isin(uniquelist::as_view(x.size(), x.data())));
+    x[0] = 1.1;
+    EXPECT_FALSE(list.isin(uniquelist::as_view(x.size(), x.data())));
+  }
+
+  EXPECT_EQ(std::size(list), 3);
+
+  {
+    std::vector<double> out;
+    for (auto it = list.sbegin(), end = list.send(); it != end; ++it) {
+      out.push_back(it->ptr[0]);
+    }
+    std::vector<double> expected = {1.0, 2.9, 3.4};
+    EXPECT_EQ(out, expected);
+  }
+
+  list.erase(0);
+  EXPECT_EQ(std::size(list), 2);
+}
+
+TEST(TestUtilsUniqueList, TestUniquelistWithViewsAndGridMap) {
+  using pointer = std::unique_ptr<double[]>;
+  using array = uniquelist::sized_ptr<pointer>;
+  uniquelist::uniquelist<array, uniquelist::strictly_less, uniquelist::grid_map>
+      list{uniquelist::strictly_less{1e-6, 1e-6}};
+  auto copy = [](const auto &x) { return uniquelist::copy_as<pointer>(x); };
+  std::vector<double> x = {1.0, 2.0};
+  std::vector<double> y = {1.0, 2.0000000001};
+  EXPECT_EQ(
+      list.push_back_with_hook(uniquelist::as_view(x.size(), x.data()), copy),
+      std::make_pair(size_t{0}, true));
+  EXPECT_EQ(
+      list.push_back_with_hook(uniquelist::as_view(y.size(), y.data()), copy),
+      std::make_pair(size_t{0}, false));
+  EXPECT_TRUE(list.isin(uniquelist::as_view(y.size(), y.data())));
+}